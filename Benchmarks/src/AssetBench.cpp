@@ -0,0 +1,344 @@
+/****************************************************************************
+Headless benchmark for the asset pipeline used by the demos, this times
+assimp import for each post process preset, the conversion done by Mesh and
+the per frame bone evaluation. No GL context is needed.
+****************************************************************************/
+#include "Mesh.h"
+#include "MappedIOSystem.h"
+#include "ArchiveIOSystem.h"
+#include "TimingSummary.h"
+#include <assimp/Importer.hpp>
+#include <assimp/postprocess.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+
+namespace fs = std::filesystem;
+
+// summary of a set of timings in milliseconds
+using Stats = TimingSummary::Summary;
+
+static Stats makeStats(std::vector<double> _times)
+{
+  return TimingSummary::summarise(std::move(_times));
+}
+
+static void writeStats(std::ostream &_out, const Stats &_s)
+{
+  _out << "{\"min\": " << _s.min << ", \"median\": " << _s.median
+       << ", \"p99\": " << _s.p99 << ", \"samples\": " << _s.samples << "}";
+}
+
+// assimp's error strings can contain quotes, backslashes and file paths
+static std::string jsonEscape(const std::string &_s)
+{
+  std::string escaped;
+  for (char c : _s)
+  {
+    if (c == '"' || c == '\\')
+    {
+      escaped += '\\';
+      escaped += c;
+    }
+    else if (static_cast<unsigned char>(c) < 0x20)
+    {
+      escaped += ' ';
+    }
+    else
+    {
+      escaped += c;
+    }
+  }
+  return escaped;
+}
+
+template <typename Func>
+static double timeMs(Func &&_f)
+{
+  auto start = std::chrono::steady_clock::now();
+  _f();
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+// read the files with MappedIOSystem rather than assimp's default stdio IO
+static bool s_mappedIO = false;
+// or read everything from one packed archive
+static std::shared_ptr<AssetArchive> s_archive;
+
+static void setIO(Assimp::Importer &_importer)
+{
+  if (s_archive)
+  {
+    _importer.SetIOHandler(new ArchiveIOSystem(s_archive));
+  }
+  else if (s_mappedIO)
+  {
+    // the importer owns the IO system
+    _importer.SetIOHandler(new MappedIOSystem);
+  }
+}
+
+static const char *ioName()
+{
+  return s_archive ? "archive" : (s_mappedIO ? "mapped" : "default");
+}
+
+// peak resident set size of this process in KB
+static long peakRSSKB()
+{
+  rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss;
+}
+
+struct Preset
+{
+  const char *name;
+  unsigned int flags;
+};
+
+// the same presets the demos choose between
+static const Preset s_presets[] = {
+    {"fast", aiProcessPreset_TargetRealtime_Fast | aiProcess_Triangulate},
+    {"quality", aiProcessPreset_TargetRealtime_Quality | aiProcess_Triangulate},
+    {"maxQuality", aiProcessPreset_TargetRealtime_MaxQuality | aiProcess_Triangulate}};
+
+struct FileResult
+{
+  std::string file;
+  std::vector<std::pair<std::string, Stats>> import;
+  Stats convert;
+  Stats boneTransform;
+  size_t frames = 0;
+  bool animated = false;
+  // set when the file couldn't be imported, convert and boneTransform are then not measured
+  std::string error;
+};
+
+static FileResult benchFile(const std::string &_fname, size_t _iterations)
+{
+  FileResult result;
+  result.file = _fname;
+  const std::string &fname = _fname;
+
+  for (auto &preset : s_presets)
+  {
+    std::vector<double> times;
+    for (size_t i = 0; i < _iterations; ++i)
+    {
+      // a fresh importer each time so nothing is cached between runs
+      Assimp::Importer importer;
+      setIO(importer);
+      times.push_back(timeMs([&]() { importer.ReadFile(fname, preset.flags); }));
+    }
+    result.import.emplace_back(preset.name, makeStats(times));
+  }
+
+  // the rest uses the same preset as SkeletalAnimation
+  Assimp::Importer importer;
+  setIO(importer);
+  const aiScene *scene = importer.ReadFile(fname, aiProcessPreset_TargetRealtime_Quality | aiProcess_Triangulate);
+  if (scene == nullptr)
+  {
+    result.error = importer.GetErrorString();
+    std::cerr << "Assimp reports " << result.error << "\n";
+    return result;
+  }
+
+  std::vector<double> times;
+  for (size_t i = 0; i < _iterations; ++i)
+  {
+    Mesh mesh;
+    Mesh::GeometryData data;
+    times.push_back(timeMs([&]() { mesh.loadData(scene, data); }));
+  }
+  result.convert = makeStats(times);
+
+  if (scene->mNumAnimations > 0)
+  {
+    result.animated = true;
+    Mesh mesh;
+    Mesh::GeometryData data;
+    mesh.loadData(scene, data);
+    double ticksPerSec = mesh.getTicksPerSec() != 0.0 ? mesh.getTicksPerSec() : 25.0;
+    double duration = mesh.getDuration() / ticksPerSec;
+    // sample the whole clip at 60fps
+    result.frames = std::max<size_t>(1, static_cast<size_t>(std::ceil(duration * 60.0)));
+    std::vector<ngl::Mat4> transforms;
+    times.clear();
+    for (size_t i = 0; i < _iterations; ++i)
+    {
+      for (size_t f = 0; f < result.frames; ++f)
+      {
+        float t = static_cast<float>(f) / 60.0f;
+        times.push_back(timeMs([&]() { mesh.boneTransform(t, transforms); }));
+      }
+    }
+    result.boneTransform = makeStats(times);
+  }
+  return result;
+}
+
+int main(int argc, char **argv)
+{
+  // usage AssetBench [--models dir] [--iterations n] [--io default|mapped] [--archive pack] [--out results.json]
+  fs::path models("Models");
+  size_t iterations = 10;
+  std::string outName("AssetBench.json");
+  std::string archiveName;
+  // std::stoul throws on anything that isn't a number, report it with the usage rather than terminating
+  bool badUsage = false;
+  bool badNumber = false;
+  try
+  {
+    for (int i = 1; i < argc && !badUsage; ++i)
+    {
+      std::string arg(argv[i]);
+      if (arg == "--models" && i + 1 < argc)
+      {
+        models = argv[++i];
+      }
+      else if (arg == "--iterations" && i + 1 < argc)
+      {
+        iterations = std::max(1ul, std::stoul(argv[++i]));
+      }
+      else if (arg == "--io" && i + 1 < argc && (std::string(argv[i + 1]) == "default" || std::string(argv[i + 1]) == "mapped"))
+      {
+        s_mappedIO = std::string(argv[++i]) == "mapped";
+      }
+      else if (arg == "--archive" && i + 1 < argc)
+      {
+        archiveName = argv[++i];
+      }
+      else if (arg == "--out" && i + 1 < argc)
+      {
+        outName = argv[++i];
+      }
+      else
+      {
+        badUsage = true;
+      }
+    }
+  }
+  catch (const std::exception &)
+  {
+    badNumber = true;
+  }
+  if (badUsage || badNumber)
+  {
+    if (badNumber)
+    {
+      std::cout << "expected a number after an option\n";
+    }
+    std::cout << "usage AssetBench [--models dir] [--iterations n] [--io default|mapped] [--archive pack] [--out results.json]\n";
+    return EXIT_FAILURE;
+  }
+  // gather everything assimp thinks it can load, sorted so runs are comparable
+  std::vector<std::string> files;
+  Assimp::Importer probe;
+  double archiveOpenMs = 0.0;
+  if (!archiveName.empty())
+  {
+    archiveOpenMs = timeMs([&]() { s_archive = AssetArchive::open(archiveName); });
+    if (!s_archive)
+    {
+      return EXIT_FAILURE;
+    }
+    std::cout << "opened " << archiveName << " in " << archiveOpenMs << " ms\n";
+    for (auto &name : s_archive->names())
+    {
+      if (probe.IsExtensionSupported(fs::path(name).extension().string()))
+      {
+        files.push_back(name);
+      }
+    }
+  }
+  else
+  {
+    if (!fs::is_directory(models))
+    {
+      std::cerr << models << " is not a directory\n";
+      return EXIT_FAILURE;
+    }
+    for (auto &entry : fs::recursive_directory_iterator(models))
+    {
+      if (entry.is_regular_file() && probe.IsExtensionSupported(entry.path().extension().string()))
+      {
+        files.push_back(entry.path().generic_string());
+      }
+    }
+  }
+  std::sort(files.begin(), files.end());
+
+  std::vector<FileResult> results;
+  for (auto &f : files)
+  {
+    std::cout << "benchmarking " << f << "\n";
+    results.push_back(benchFile(f, iterations));
+    auto &r = results.back();
+    for (auto &imp : r.import)
+    {
+      std::cout << "  import " << imp.first << " median " << imp.second.median << " ms\n";
+    }
+    if (!r.error.empty())
+    {
+      std::cout << "  failed to import, no convert or boneTransform times\n";
+      continue;
+    }
+    std::cout << "  convert median " << r.convert.median << " ms\n";
+    if (r.animated)
+    {
+      std::cout << "  boneTransform median " << r.boneTransform.median << " ms p99 " << r.boneTransform.p99 << " ms\n";
+    }
+  }
+
+  long peakRSS = peakRSSKB();
+  std::cout << "io " << ioName() << " peak RSS " << peakRSS << " KB\n";
+
+  std::ofstream out(outName);
+  if (!out)
+  {
+    std::cerr << "unable to write " << outName << "\n";
+    return EXIT_FAILURE;
+  }
+  out << "{\n  \"units\": \"ms\",\n  \"iterations\": " << iterations
+      << ",\n  \"io\": \"" << ioName() << "\""
+      << ",\n  \"archiveOpen\": " << archiveOpenMs
+      << ",\n  \"peakRSSKB\": " << peakRSS << ",\n  \"files\": [\n";
+  for (size_t i = 0; i < results.size(); ++i)
+  {
+    auto &r = results[i];
+    out << "    {\n      \"file\": \"" << r.file << "\",\n      \"import\": {";
+    for (size_t p = 0; p < r.import.size(); ++p)
+    {
+      out << (p ? ", " : "") << "\"" << r.import[p].first << "\": ";
+      writeStats(out, r.import[p].second);
+    }
+    out << "}";
+    if (!r.error.empty())
+    {
+      out << ",\n      \"error\": \"" << jsonEscape(r.error) << "\"";
+    }
+    else
+    {
+      out << ",\n      \"convert\": ";
+      writeStats(out, r.convert);
+    }
+    if (r.animated)
+    {
+      out << ",\n      \"frames\": " << r.frames << ",\n      \"boneTransform\": ";
+      writeStats(out, r.boneTransform);
+    }
+    out << "\n    }" << (i + 1 < results.size() ? "," : "") << "\n";
+  }
+  out << "  ]\n}\n";
+  std::cout << "results written to " << outName << "\n";
+  return EXIT_SUCCESS;
+}
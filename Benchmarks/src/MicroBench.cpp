@@ -0,0 +1,274 @@
+/****************************************************************************
+Micro benchmarks for the small functions that run per bone, per key, per frame
+when animating. Built with google benchmark so results can be saved with
+--benchmark_out=file.json and two builds compared with its compare.py tool.
+****************************************************************************/
+#include "AIUtil.h"
+#include "Mesh.h"
+#include <benchmark/benchmark.h>
+#include <ngl/Mat4.h>
+#include <ngl/Quaternion.h>
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace
+{
+  // every run uses the same data so builds can be compared
+  constexpr unsigned int s_seed = 1234;
+  // number of pre generated sample times, a power of 2 so we can wrap with a mask
+  constexpr size_t s_numTimes = 4096;
+
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief make a channel with _numKeys evenly spaced keys (one tick apart) of random data, the
+  /// key arrays are owned by the aiNodeAnim as they would be from the importer
+  //----------------------------------------------------------------------------------------------------------------------
+  std::unique_ptr<aiNodeAnim> makeChannel(unsigned int _numKeys, std::mt19937 &_rng)
+  {
+    std::uniform_real_distribution<float> value(-1.0f, 1.0f);
+    auto channel = std::make_unique<aiNodeAnim>();
+    channel->mNumPositionKeys = _numKeys;
+    channel->mNumRotationKeys = _numKeys;
+    channel->mNumScalingKeys = _numKeys;
+    channel->mPositionKeys = new aiVectorKey[_numKeys];
+    channel->mRotationKeys = new aiQuatKey[_numKeys];
+    channel->mScalingKeys = new aiVectorKey[_numKeys];
+    for (unsigned int i = 0; i < _numKeys; ++i)
+    {
+      double time = static_cast<double>(i);
+      channel->mPositionKeys[i].mTime = time;
+      channel->mPositionKeys[i].mValue = aiVector3D(value(_rng), value(_rng), value(_rng));
+      channel->mScalingKeys[i].mTime = time;
+      channel->mScalingKeys[i].mValue = aiVector3D(1.0f + 0.1f * value(_rng), 1.0f, 1.0f);
+      aiQuaternion q(value(_rng), value(_rng), value(_rng), value(_rng));
+      q.Normalize();
+      channel->mRotationKeys[i].mTime = time;
+      channel->mRotationKeys[i].mValue = q;
+    }
+    return channel;
+  }
+
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief sample times in [0, _numKeys-1), sequential walks forward through the clip in small
+  /// steps (like playback) random jumps anywhere (like a crowd with per instance offsets)
+  //----------------------------------------------------------------------------------------------------------------------
+  std::vector<float> makeTimes(unsigned int _numKeys, bool _random, std::mt19937 &_rng)
+  {
+    std::vector<float> times(s_numTimes);
+    float duration = static_cast<float>(_numKeys - 1);
+    if (_random)
+    {
+      std::uniform_real_distribution<float> t(0.0f, duration);
+      std::generate(times.begin(), times.end(), [&]() { return t(_rng); });
+    }
+    else
+    {
+      for (size_t i = 0; i < times.size(); ++i)
+      {
+        times[i] = duration * static_cast<float>(i) / static_cast<float>(times.size());
+      }
+    }
+    return times;
+  }
+
+  aiMatrix4x4 makeMatrix(std::mt19937 &_rng)
+  {
+    std::uniform_real_distribution<float> value(-1.0f, 1.0f);
+    aiMatrix4x4 m;
+    for (unsigned int r = 0; r < 4; ++r)
+    {
+      for (unsigned int c = 0; c < 4; ++c)
+      {
+        m[r][c] = value(_rng);
+      }
+    }
+    return m;
+  }
+} // end anon namespace
+
+//----------------------------------------------------------------------------------------------------------------------
+// AIU conversions
+//----------------------------------------------------------------------------------------------------------------------
+static void BM_aiMatrix4x4ToNGLMat4(benchmark::State &_state)
+{
+  std::mt19937 rng(s_seed);
+  std::vector<aiMatrix4x4> src(s_numTimes);
+  std::generate(src.begin(), src.end(), [&]() { return makeMatrix(rng); });
+  size_t i = 0;
+  for (auto _ : _state)
+  {
+    ngl::Mat4 m = AIU::aiMatrix4x4ToNGLMat4(src[i++ & (s_numTimes - 1)]);
+    benchmark::DoNotOptimize(m);
+  }
+  _state.SetItemsProcessed(_state.iterations());
+}
+BENCHMARK(BM_aiMatrix4x4ToNGLMat4);
+
+static void BM_aiMatrix4x4ToNGLMat4Transpose(benchmark::State &_state)
+{
+  std::mt19937 rng(s_seed);
+  std::vector<aiMatrix4x4> src(s_numTimes);
+  std::generate(src.begin(), src.end(), [&]() { return makeMatrix(rng); });
+  size_t i = 0;
+  for (auto _ : _state)
+  {
+    ngl::Mat4 m = AIU::aiMatrix4x4ToNGLMat4Transpose(src[i++ & (s_numTimes - 1)]);
+    benchmark::DoNotOptimize(m);
+  }
+  _state.SetItemsProcessed(_state.iterations());
+}
+BENCHMARK(BM_aiMatrix4x4ToNGLMat4Transpose);
+
+static void BM_aiQuatToNGLQuat(benchmark::State &_state)
+{
+  std::mt19937 rng(s_seed);
+  std::uniform_real_distribution<float> value(-1.0f, 1.0f);
+  std::vector<aiQuaternion> src(s_numTimes);
+  std::generate(src.begin(), src.end(), [&]() { return aiQuaternion(value(rng), value(rng), value(rng), value(rng)); });
+  size_t i = 0;
+  for (auto _ : _state)
+  {
+    ngl::Quaternion q = AIU::aiQuatToNGLQuat(src[i++ & (s_numTimes - 1)]);
+    benchmark::DoNotOptimize(q);
+  }
+  _state.SetItemsProcessed(_state.iterations());
+}
+BENCHMARK(BM_aiQuatToNGLQuat);
+
+//----------------------------------------------------------------------------------------------------------------------
+// the slerp / normalise that ends every rotation lookup
+//----------------------------------------------------------------------------------------------------------------------
+static void BM_SlerpNormalise(benchmark::State &_state)
+{
+  std::mt19937 rng(s_seed);
+  std::uniform_real_distribution<float> value(-1.0f, 1.0f);
+  std::vector<ngl::Quaternion> src(s_numTimes + 1);
+  for (auto &q : src)
+  {
+    q = ngl::Quaternion(value(rng), value(rng), value(rng), value(rng));
+    q.normalise();
+  }
+  size_t i = 0;
+  for (auto _ : _state)
+  {
+    size_t a = i++ & (s_numTimes - 1);
+    ngl::Quaternion out = ngl::Quaternion::slerp(src[a], src[a + 1], 0.5f);
+    out.normalise();
+    benchmark::DoNotOptimize(out);
+  }
+  _state.SetItemsProcessed(_state.iterations());
+}
+BENCHMARK(BM_SlerpNormalise);
+
+//----------------------------------------------------------------------------------------------------------------------
+// single channel key lookup and interpolation
+// args are the key count and 0 for sequential / 1 for random access
+//----------------------------------------------------------------------------------------------------------------------
+static void keyArgs(benchmark::internal::Benchmark *_b)
+{
+  for (int keys : {2, 16, 128, 1024})
+  {
+    for (int random : {0, 1})
+    {
+      _b->Args({keys, random});
+    }
+  }
+  _b->ArgNames({"keys", "random"});
+}
+
+static void BM_CalcInterpolatedRotation(benchmark::State &_state)
+{
+  std::mt19937 rng(s_seed);
+  auto numKeys = static_cast<unsigned int>(_state.range(0));
+  auto channel = makeChannel(numKeys, rng);
+  auto times = makeTimes(numKeys, _state.range(1) != 0, rng);
+  size_t i = 0;
+  for (auto _ : _state)
+  {
+    ngl::Quaternion q = Mesh::calcInterpolatedRotation(times[i++ & (s_numTimes - 1)], channel.get());
+    benchmark::DoNotOptimize(q);
+  }
+  _state.SetItemsProcessed(_state.iterations());
+}
+BENCHMARK(BM_CalcInterpolatedRotation)->Apply(keyArgs);
+
+static void BM_CalcInterpolatedPosition(benchmark::State &_state)
+{
+  std::mt19937 rng(s_seed);
+  auto numKeys = static_cast<unsigned int>(_state.range(0));
+  auto channel = makeChannel(numKeys, rng);
+  auto times = makeTimes(numKeys, _state.range(1) != 0, rng);
+  size_t i = 0;
+  for (auto _ : _state)
+  {
+    ngl::Vec3 p = Mesh::calcInterpolatedPosition(times[i++ & (s_numTimes - 1)], channel.get());
+    benchmark::DoNotOptimize(p);
+  }
+  _state.SetItemsProcessed(_state.iterations());
+}
+BENCHMARK(BM_CalcInterpolatedPosition)->Apply(keyArgs);
+
+static void BM_CalcInterpolatedScaling(benchmark::State &_state)
+{
+  std::mt19937 rng(s_seed);
+  auto numKeys = static_cast<unsigned int>(_state.range(0));
+  auto channel = makeChannel(numKeys, rng);
+  auto times = makeTimes(numKeys, _state.range(1) != 0, rng);
+  size_t i = 0;
+  for (auto _ : _state)
+  {
+    ngl::Vec3 s = Mesh::calcInterpolatedScaling(times[i++ & (s_numTimes - 1)], channel.get());
+    benchmark::DoNotOptimize(s);
+  }
+  _state.SetItemsProcessed(_state.iterations());
+}
+BENCHMARK(BM_CalcInterpolatedScaling)->Apply(keyArgs);
+
+//----------------------------------------------------------------------------------------------------------------------
+// the per bone work done by Mesh::recurseNodeHeirarchy for a whole pose (scale, rotate, translate
+// then build the node matrix) without the scene walk. Args are bone count, keys per channel and
+// sequential / random access. ns/op is per pose, items/s is bones per second
+//----------------------------------------------------------------------------------------------------------------------
+static void BM_PoseChannels(benchmark::State &_state)
+{
+  std::mt19937 rng(s_seed);
+  auto numBones = static_cast<size_t>(_state.range(0));
+  auto numKeys = static_cast<unsigned int>(_state.range(1));
+  std::vector<std::unique_ptr<aiNodeAnim>> channels;
+  for (size_t b = 0; b < numBones; ++b)
+  {
+    channels.push_back(makeChannel(numKeys, rng));
+  }
+  auto times = makeTimes(numKeys, _state.range(2) != 0, rng);
+  std::vector<ngl::Mat4> pose(numBones);
+  size_t i = 0;
+  for (auto _ : _state)
+  {
+    float time = times[i++ & (s_numTimes - 1)];
+    for (size_t b = 0; b < numBones; ++b)
+    {
+      // random access means each bone (like each crowd member) is at a different point in the clip
+      if (_state.range(2) != 0)
+      {
+        time = times[(i + b) & (s_numTimes - 1)];
+      }
+      ngl::Vec3 scale = Mesh::calcInterpolatedScaling(time, channels[b].get());
+      ngl::Quaternion rotation = Mesh::calcInterpolatedRotation(time, channels[b].get());
+      ngl::Vec3 translation = Mesh::calcInterpolatedPosition(time, channels[b].get());
+      ngl::Mat4 nodeTransform = ngl::Mat4::scale(scale.m_x, scale.m_y, scale.m_z) * rotation.toMat4();
+      nodeTransform.m_30 = translation.m_x;
+      nodeTransform.m_31 = translation.m_y;
+      nodeTransform.m_32 = translation.m_z;
+      pose[b] = nodeTransform;
+    }
+    benchmark::DoNotOptimize(pose.data());
+    benchmark::ClobberMemory();
+  }
+  _state.SetItemsProcessed(_state.iterations() * static_cast<int64_t>(numBones));
+}
+BENCHMARK(BM_PoseChannels)
+    ->ArgsProduct({{16, 64, 256}, {16, 256}, {0, 1}})
+    ->ArgNames({"bones", "keys", "random"});
+
+BENCHMARK_MAIN();
@@ -0,0 +1,76 @@
+#ifndef ASSETARCHIVE_H_
+#define ASSETARCHIVE_H_
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @class AssetArchive
+/// @brief a read only pack of many files in one, so a model and everything it depends on can be loaded
+/// with a single open and mapping. The layout (all values little endian) is
+/// header   : char magic[4] "AIPK", uint32 version, uint64 entry count
+/// index    : per entry uint64 offset, uint64 size, uint64 FNV-1a hash, uint32 name length, name bytes
+/// data     : the file contents, each one starts on a 16 byte boundary
+/// names are relative paths using / as the separator
+//----------------------------------------------------------------------------------------------------------------------
+class AssetArchive
+{
+  public :
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief a file in the archive, data points into the mapping so is valid as long as the archive is
+    //----------------------------------------------------------------------------------------------------------------------
+    struct Entry
+    {
+      const uint8_t *data;
+      size_t size;
+      uint64_t hash;
+    };
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief map an archive and read its index
+    /// @param[in] _fname the archive to open
+    /// @returns the archive or nullptr if it can't be opened or is not valid
+    //----------------------------------------------------------------------------------------------------------------------
+    static std::shared_ptr<AssetArchive> open(const std::string &_fname);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief write an archive
+    /// @param[in] _fname the archive to create
+    /// @param[in] _files pairs of the name to store and the file on disk to read
+    /// @returns true on success
+    //----------------------------------------------------------------------------------------------------------------------
+    static bool write(const std::string &_fname, const std::vector<std::pair<std::string, std::string>> &_files);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the hash stored for each entry (64 bit FNV-1a)
+    //----------------------------------------------------------------------------------------------------------------------
+    static uint64_t hash(const uint8_t *_data, size_t _size);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief tidy a path into the form used for names, \ becomes / and . and .. segments are removed
+    //----------------------------------------------------------------------------------------------------------------------
+    static std::string normalise(const std::string &_path);
+    ~AssetArchive();
+    AssetArchive(const AssetArchive &)=delete;
+    AssetArchive &operator=(const AssetArchive &)=delete;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief look up a file, the name is normalised first
+    /// @returns the entry or nullptr if it is not in the archive
+    //----------------------------------------------------------------------------------------------------------------------
+    const Entry *find(const std::string &_name) const;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the names of all the files in the order they are stored
+    //----------------------------------------------------------------------------------------------------------------------
+    const std::vector<std::string> &names() const { return m_names; }
+
+  private :
+    AssetArchive()=default;
+    const uint8_t *m_data=nullptr;
+    size_t m_size=0;
+    /// @brief used instead of a mapping on platforms without mmap
+    std::vector<uint8_t> m_buffer;
+    std::vector<std::string> m_names;
+    std::unordered_map<std::string, Entry> m_entries;
+};
+
+#endif
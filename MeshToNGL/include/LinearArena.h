@@ -0,0 +1,98 @@
+#ifndef LINEARARENA_H_
+#define LINEARARENA_H_
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @class LinearArena
+/// @brief a monotonic allocator for load time scratch. Allocations are bumped out of large blocks and never
+/// freed on their own, everything goes at once when the arena is released or destroyed, so converting a
+/// model costs a handful of heap allocations however many temporary buffers it uses and leaves no holes
+/// behind in the heap. Not thread safe, use one arena per load.
+//----------------------------------------------------------------------------------------------------------------------
+class LinearArena
+{
+  public :
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief what the arena has done since it was created or last released
+    //----------------------------------------------------------------------------------------------------------------------
+    struct Stats
+    {
+      /// @brief allocations served by the arena
+      size_t allocations=0;
+      /// @brief bytes asked for
+      size_t bytes=0;
+      /// @brief heap allocations made by the arena for its blocks
+      size_t blocks=0;
+      /// @brief total size of the blocks
+      size_t blockBytes=0;
+    };
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief ctor, no memory is allocated until the first allocate
+    /// @param[in] _blockSize the size of each block, allocations that won't fit in one get a block of their
+    /// own and the current block carries on being used
+    //----------------------------------------------------------------------------------------------------------------------
+    explicit LinearArena(size_t _blockSize=1<<20);
+    LinearArena(const LinearArena &)=delete;
+    LinearArena &operator=(const LinearArena &)=delete;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief allocate memory from the current block, starting a new one if it doesn't fit
+    /// @param[in] _bytes the size to allocate
+    /// @param[in] _alignment must be a power of 2
+    //----------------------------------------------------------------------------------------------------------------------
+    void *allocate(size_t _bytes, size_t _alignment=alignof(std::max_align_t));
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief free every block at once, anything allocated from the arena must no longer be used
+    //----------------------------------------------------------------------------------------------------------------------
+    void release();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief accessor for the counts since the last release
+    //----------------------------------------------------------------------------------------------------------------------
+    const Stats &stats() const { return m_stats; }
+
+  private :
+    size_t m_blockSize;
+    std::vector<std::unique_ptr<std::byte[]>> m_blocks;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the free space at the end of the current block
+    //----------------------------------------------------------------------------------------------------------------------
+    std::byte *m_current=nullptr;
+    size_t m_remaining=0;
+    Stats m_stats;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @class ArenaAllocator
+/// @brief a standard allocator that takes its memory from a LinearArena so containers can use it,
+/// deallocate does nothing as the memory goes when the arena does
+//----------------------------------------------------------------------------------------------------------------------
+template <typename T>
+class ArenaAllocator
+{
+  public :
+    using value_type=T;
+    ArenaAllocator(LinearArena &_arena) : m_arena(&_arena) {}
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U> &_other) : m_arena(_other.arena()) {}
+    T *allocate(size_t _n) { return static_cast<T *>(m_arena->allocate(_n * sizeof(T), alignof(T))); }
+    void deallocate(T *, size_t) {}
+    LinearArena *arena() const { return m_arena; }
+    template <typename U>
+    bool operator==(const ArenaAllocator<U> &_other) const { return m_arena == _other.arena(); }
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U> &_other) const { return m_arena != _other.arena(); }
+
+  private :
+    LinearArena *m_arena;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief a vector living in an arena, reserve the final size up front as growing leaves the old storage
+/// unused until the arena is released
+//----------------------------------------------------------------------------------------------------------------------
+template <typename T>
+using ArenaVector=std::vector<T,ArenaAllocator<T>>;
+
+#endif
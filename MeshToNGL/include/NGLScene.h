@@ -1,10 +1,18 @@
 #ifndef NGLSCENE_H_
 #define NGLSCENE_H_
 #include "WindowParams.h"
+#include "AssetArchive.h"
+#include "LinearArena.h"
+#include "SceneGraph.h"
+#include "Simplify.h"
+#include "TransformBuffer.h"
+#include "UniformBinding.h"
 #include <ngl/AbstractVAO.h>
 #include <ngl/Transformation.h>
 #include <assimp/scene.h>
+#include <assimp/Importer.hpp>
 #include <QOpenGLWindow>
+#include <array>
 #include <memory>
 //----------------------------------------------------------------------------------------------------------------------
 /// @file NGLScene.h
@@ -24,9 +32,16 @@ class NGLScene : public QOpenGLWindow
   public:
     //----------------------------------------------------------------------------------------------------------------------
     /// @brief ctor for our NGL drawing class
-    /// @param [in] parent the parent window to the class
+    /// @param [in] _fname the file to load
+    /// @param [in] _numInstances how many copies of the model to draw, these are laid out in a grid
+    /// and drawn with a single instanced draw per mesh
+    /// @param [in] _importFlags the assimp post process flags (see ImportProfile), FixInfacingNormals
+    /// is always added
+    /// @param [in] _timeImport print the time taken by each import step
+    /// @param [in] _archive if set the file (and anything it references) is read from this archive
     //----------------------------------------------------------------------------------------------------------------------
-    NGLScene(const std::string &_fname);
+    NGLScene(const std::string &_fname, size_t _numInstances, unsigned int _importFlags, bool _timeImport=false,
+             std::shared_ptr<AssetArchive> _archive=nullptr);
     //----------------------------------------------------------------------------------------------------------------------
     /// @brief dtor must close down ngl and release OpenGL resources
     //----------------------------------------------------------------------------------------------------------------------
@@ -44,6 +59,13 @@ class NGLScene : public QOpenGLWindow
     /// @brief resize event called everytime a window is resized
     //----------------------------------------------------------------------------------------------------------------------
     void resizeGL(int _w, int _h);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief set the camera for a given frame rather than using the mouse, the camera orbits the model
+    /// once over the run
+    /// @param [in] _frame the frame to draw
+    /// @param [in] _numFrames how many frames are in the run
+    //----------------------------------------------------------------------------------------------------------------------
+    void setFixedFrame(size_t _frame, size_t _numFrames);
 private:
     //----------------------------------------------------------------------------------------------------------------------
     /// @brief used to store the x rotation mouse value
@@ -70,17 +92,154 @@ private:
     /// @brief a simple light use to illuminate the screen
     //----------------------------------------------------------------------------------------------------------------------
     const aiScene* m_scene;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the importer owns the scene
+    //----------------------------------------------------------------------------------------------------------------------
+    Assimp::Importer m_importer;
 
-    /// @brief our mesh with local transform and VAO
-     struct meshItem
+    /// @brief the uploaded geometry of one aiMesh, this is shared by every node that references it
+     struct meshGeometry
      {
-       ngl::Mat4 tx;
+       /// @brief null if the mesh had no triangles
        std::unique_ptr< ngl::AbstractVAO> vao;
+       /// @brief the index range of each LOD, all levels live in the one index buffer
+       size_t numLODs=1;
+       std::array<unsigned int,Simplify::s_maxLODs> lodBase;
+       std::array<unsigned int,Simplify::s_maxLODs> lodCount;
+       /// @brief GL_UNSIGNED_SHORT when the mesh has few enough vertices, else GL_UNSIGNED_INT
+       GLenum indexType=GL_UNSIGNED_INT;
+       /// @brief bounding sphere of the vertices relative to the node
+       ngl::Vec3 localCentre;
+       float localRadius=0.0f;
+       /// @brief the references to this mesh are m_drawOrder[firstRef, firstRef+numRefs)
+       unsigned int firstRef=0;
+       unsigned int numRefs=0;
+       /// @brief world space sphere around every reference, the LOD of each copy is chosen from this
+       ngl::Vec3 centre;
+       float radius=0.0f;
+       /// @brief where this mesh's copies of the grid start in m_instanceBuffer
+       unsigned int firstInstance=0;
      };
-
+    /// @brief a node's reference to a mesh, the geometry is m_geometry[geometry]
+     struct meshItem
+     {
+       /// @brief the node in m_graph, this is also the draw id in m_transforms
+       unsigned int node=0;
+       unsigned int geometry=0;
+       /// @brief bounding sphere in world space used to choose the LOD, this is moved with the node
+       ngl::Vec3 centre;
+       float radius=0.0f;
+     };
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief one entry per aiMesh (same index as aiScene::mMeshes) uploaded once however many
+    /// nodes use it
+    //----------------------------------------------------------------------------------------------------------------------
+    std::vector<meshGeometry> m_geometry;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief every node / mesh reference in node order
+    //----------------------------------------------------------------------------------------------------------------------
     std::vector<meshItem > m_meshes;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief m_meshes sorted by geometry so references to the same mesh are drawn with one VAO bind
+    //----------------------------------------------------------------------------------------------------------------------
+    std::vector<unsigned int> m_drawOrder;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief number of copies of the model to draw
+    //----------------------------------------------------------------------------------------------------------------------
+    size_t m_numInstances=1;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief print the load details (--import-timing)
+    //----------------------------------------------------------------------------------------------------------------------
+    bool m_timeImport=false;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief buffer of per instance model matrices, this is shared by all the mesh VAO's. Each referenced mesh
+    /// has its own copy of the grid sorted by LOD, which is only rewritten when the LODs of its copies change
+    //----------------------------------------------------------------------------------------------------------------------
+    GLuint m_instanceBuffer=0;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the grid matrix of each instance
+    //----------------------------------------------------------------------------------------------------------------------
+    std::vector<ngl::Mat4> m_instances;
+    /// @brief count copies of m_geometry[geometry] at one LOD starting at first in m_instanceBuffer, this is
+    /// drawn once for every reference to the mesh
+    struct lodDraw
+    {
+      unsigned int geometry=0;
+      unsigned int lod=0;
+      unsigned int first=0;
+      unsigned int count=0;
+    };
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the current draws, the sorted instance matrices and the LOD of every copy last uploaded
+    //----------------------------------------------------------------------------------------------------------------------
+    std::vector<lodDraw> m_lodDraws;
+    std::vector<ngl::Mat4> m_frameInstances;
+    std::vector<unsigned int> m_instanceLODs;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the model view the LODs were chosen with, they are only chosen again when this changes or
+    /// m_lodsDirty is set because a node moved
+    //----------------------------------------------------------------------------------------------------------------------
+    ngl::Mat4 m_lodMV;
+    bool m_lodsDirty=true;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the node hierarchy of the scene, flattened so moving a node only updates its subtree
+    //----------------------------------------------------------------------------------------------------------------------
+    SceneGraph m_graph;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the subtrees recalculated by the last graph update, kept to avoid allocating every frame
+    //----------------------------------------------------------------------------------------------------------------------
+    std::vector<SceneGraph::Range> m_movedNodes;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the world and normal matrix of every node, the shader indexes this by draw id
+    //----------------------------------------------------------------------------------------------------------------------
+    std::unique_ptr<TransformBuffer> m_transforms;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the node moved by the keyboard
+    //----------------------------------------------------------------------------------------------------------------------
+    unsigned int m_selectedNode=0;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the camera and light uniform block
+    //----------------------------------------------------------------------------------------------------------------------
+    std::unique_ptr<FrameUniforms> m_frameUniforms;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief lay the instances out in a grid and upload the matrices to m_instanceBuffer
+    /// @param [in] _spacing distance between each copy
+    //----------------------------------------------------------------------------------------------------------------------
+    void buildInstanceBuffer(float _spacing);
     void buildVAOFromScene();
-    void recurseScene(const  aiScene *sc, const  aiNode* nd,const ngl::Mat4 &_parentTx);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief convert one aiMesh and upload it to its own VAO
+    /// @param [in] _mesh the mesh to upload
+    /// @param [in] _arena scratch for the converted data
+    /// @param [out] o_geometry the VAO and LOD ranges, the vao is left null if there are no triangles
+    //----------------------------------------------------------------------------------------------------------------------
+    void buildGeometry(const aiMesh *_mesh, LinearArena &_arena, meshGeometry &o_geometry);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief add the nodes to m_graph and a meshItem for every mesh they reference
+    //----------------------------------------------------------------------------------------------------------------------
+    void recurseScene(const  aiScene *sc, const  aiNode* nd,unsigned int _parent);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief recalculate the world matrices of any nodes that have moved and copy just those to the
+    /// transform buffer and mesh bounds
+    //----------------------------------------------------------------------------------------------------------------------
+    void updateTransforms();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief move the bounding spheres of the mesh references in a range of nodes
+    /// @param [in] _first the first node that moved
+    /// @param [in] _end one past the last node that moved
+    //----------------------------------------------------------------------------------------------------------------------
+    void updateMeshBounds(unsigned int _first, unsigned int _end);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief work out the world sphere of each mesh from the spheres of its references
+    //----------------------------------------------------------------------------------------------------------------------
+    void updateGeometryBounds();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief choose the LOD of every copy of every mesh from where that copy is and sort each mesh's copies
+    /// in m_instanceBuffer so the ones at the same LOD are a contiguous range. Nothing is done unless the
+    /// camera or a node has moved, and only meshes whose LODs changed are uploaded again
+    /// @param [in] _MV the model view matrix the instance offsets are relative to
+    //----------------------------------------------------------------------------------------------------------------------
+    void buildLODDraws(const ngl::Mat4 &_MV);
 
     ngl::Mat4 m_rootTransform;
 
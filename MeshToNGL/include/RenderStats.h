@@ -0,0 +1,60 @@
+#ifndef RENDERSTATS_H_
+#define RENDERSTATS_H_
+
+#include <cstddef>
+#include <cstdint>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @file RenderStats.h
+/// @brief simple per frame counters for the GL work we submit. The add functions are inline
+/// increments so can be left in release builds, call beginFrame / endFrame around paintGL and read
+/// the completed frame with lastFrame.
+//----------------------------------------------------------------------------------------------------------------------
+namespace RenderStats
+{
+  struct Counters
+  {
+    size_t drawCalls=0;
+    size_t triangles=0;
+    size_t vaoBinds=0;
+    size_t programSwitches=0;
+    size_t uniformUploads=0;
+    size_t bufferBytes=0;
+  };
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the counters for the frame being drawn, use the add functions rather than this directly
+  //----------------------------------------------------------------------------------------------------------------------
+  inline Counters s_current;
+
+  inline void addDraw(size_t _indices, size_t _instances=1)
+  {
+    ++s_current.drawCalls;
+    s_current.triangles+=(_indices/3)*_instances;
+  }
+  inline void addVAOBind() { ++s_current.vaoBinds; }
+  inline void addProgramSwitch() { ++s_current.programSwitches; }
+  inline void addUniformUploads(size_t _count=1) { s_current.uniformUploads+=_count; }
+  inline void addBufferBytes(size_t _bytes) { s_current.bufferBytes+=_bytes; }
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief reset the current counters
+  //----------------------------------------------------------------------------------------------------------------------
+  extern void beginFrame();
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief store the current counters as the last frame and print a summary if it is time to
+  //----------------------------------------------------------------------------------------------------------------------
+  extern void endFrame();
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the counters from the last completed frame
+  //----------------------------------------------------------------------------------------------------------------------
+  extern const Counters &lastFrame();
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief how many frames have been completed
+  //----------------------------------------------------------------------------------------------------------------------
+  extern uint64_t frameCount();
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief print the average counters to stdout every _frames frames, 0 (the default) turns it off
+  //----------------------------------------------------------------------------------------------------------------------
+  extern void setReportInterval(size_t _frames);
+}
+
+#endif
@@ -0,0 +1,78 @@
+#ifndef SCENEGRAPH_H_
+#define SCENEGRAPH_H_
+
+#include <ngl/Mat4.h>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @class SceneGraph
+/// @brief a flattened transform hierarchy. Nodes are stored depth first so a node is always after its parent
+/// and every subtree is a contiguous range, changing a node's local matrix only recomputes the world matrices
+/// of that range and update reports the ranges so only they need to be uploaded
+//----------------------------------------------------------------------------------------------------------------------
+class SceneGraph
+{
+  public :
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief parent index of the root nodes
+    //----------------------------------------------------------------------------------------------------------------------
+    static constexpr unsigned int s_noParent=~0u;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief a run of nodes [first,end) whose world matrices were recalculated
+    //----------------------------------------------------------------------------------------------------------------------
+    struct Range
+    {
+      unsigned int first=0;
+      unsigned int end=0;
+    };
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief add a node, nodes must be added depth first (a node's children straight after it) as they are
+    /// when walking an aiNode tree recursively
+    /// @param[in] _parent the parent node or s_noParent for a root
+    /// @param[in] _local the transform relative to the parent
+    /// @returns the index of the new node
+    //----------------------------------------------------------------------------------------------------------------------
+    unsigned int addNode(unsigned int _parent, const ngl::Mat4 &_local);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief change the transform of a node relative to its parent, the world matrices of it and its
+    /// children are recalculated on the next update
+    /// @param[in] _node the node to change
+    /// @param[in] _local the new transform
+    //----------------------------------------------------------------------------------------------------------------------
+    void setLocal(unsigned int _node, const ngl::Mat4 &_local);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief recalculate the world matrix of every node under a changed node, each subtree is only
+    /// done once however many of its nodes were changed
+    /// @param[out] o_ranges the recalculated subtrees in node order, these don't overlap and nodes
+    /// between them are untouched
+    /// @returns false if nothing had changed
+    //----------------------------------------------------------------------------------------------------------------------
+    bool update(std::vector<Range> &o_ranges);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief accessors
+    //----------------------------------------------------------------------------------------------------------------------
+    const ngl::Mat4 &local(unsigned int _node) const { return m_local[_node]; }
+    const ngl::Mat4 &world(unsigned int _node) const { return m_world[_node]; }
+    unsigned int parent(unsigned int _node) const { return m_parent[_node]; }
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief one past the last node in the subtree of _node
+    //----------------------------------------------------------------------------------------------------------------------
+    unsigned int subtreeEnd(unsigned int _node) const { return m_subtreeEnd[_node]; }
+    size_t size() const { return m_local.size(); }
+
+  private :
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief per node data, all indexed by node
+    //----------------------------------------------------------------------------------------------------------------------
+    std::vector<unsigned int> m_parent;
+    std::vector<unsigned int> m_subtreeEnd;
+    std::vector<ngl::Mat4> m_local;
+    std::vector<ngl::Mat4> m_world;
+    std::vector<bool> m_dirty;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the nodes changed since the last update so it doesn't have to search for them
+    //----------------------------------------------------------------------------------------------------------------------
+    std::vector<unsigned int> m_dirtyNodes;
+};
+
+#endif
@@ -0,0 +1,90 @@
+#ifndef SIMPLIFY_H_
+#define SIMPLIFY_H_
+#include <cstddef>
+#include <vector>
+/// @brief quadric error mesh simplification used to build LOD chains from the indexed
+/// data assimp gives us. Simplification only ever collapses one existing vertex onto another
+/// so all LOD levels can share the original vertex buffer (and any bone weights in it).
+/// based on Garland and Heckbert "Surface Simplification Using Quadric Error Metrics"
+// to make things cleaner pre declare the classes
+namespace ngl
+{
+  class Mat4;
+  class Vec3;
+}
+
+namespace Simplify
+{
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the maximum number of LOD levels built, level 0 is always the source mesh
+  //----------------------------------------------------------------------------------------------------------------------
+  constexpr size_t s_maxLODs=4;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief a level is only kept if it has at most s_lodKeep numerator / denominator of the indices
+  /// of the level before it
+  //----------------------------------------------------------------------------------------------------------------------
+  constexpr size_t s_lodKeepNumerator=3;
+  constexpr size_t s_lodKeepDenominator=4;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the most indices a whole LOD chain (including level 0) built from _numIndices can have,
+  /// about 2.73 times the source with 4 levels. Use this to size index buffers up front
+  //----------------------------------------------------------------------------------------------------------------------
+  constexpr size_t maxChainIndices(size_t _numIndices)
+  {
+    size_t total=0;
+    for(size_t l=0; l<s_maxLODs; ++l)
+    {
+      total+=_numIndices;
+      _numIndices=_numIndices*s_lodKeepNumerator/s_lodKeepDenominator;
+    }
+    return total;
+  }
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief simplify an indexed triangle list until it has at most _targetIndexCount indices or no
+  /// more collapses are possible. Border and seam vertices (those sharing a position with another
+  /// vertex) are locked so the mesh does not tear.
+  /// @param[in] _positions pointer to the first position (x,y,z floats)
+  /// @param[in] _numVerts the number of vertices in the position array
+  /// @param[in] _stride the distance in floats between positions
+  /// @param[in] _indices the source triangle list
+  /// @param[in] _targetIndexCount the number of indices we would like to end up with
+  /// @param[in] _vertexGroup optional per vertex id, a vertex can only collapse onto one with the same
+  /// id, passing the dominant bone here stops skinning weights bleeding across joints
+  /// @returns the simplified triangle list referencing the original vertices
+  //----------------------------------------------------------------------------------------------------------------------
+  extern std::vector<unsigned int> simplify(const float *_positions,
+                                            size_t _numVerts,
+                                            size_t _stride,
+                                            const std::vector<unsigned int> &_indices,
+                                            size_t _targetIndexCount,
+                                            const unsigned int *_vertexGroup=nullptr);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief build a chain of LODs each with roughly half the triangles of the previous one, level 0 is
+  /// a copy of _indices. The chain stops early if the mesh will not simplify any further.
+  /// @param[out] o_lods the index lists for each level
+  //----------------------------------------------------------------------------------------------------------------------
+  extern void buildLODChain(const float *_positions,
+                            size_t _numVerts,
+                            size_t _stride,
+                            const std::vector<unsigned int> &_indices,
+                            std::vector<std::vector<unsigned int>> &o_lods,
+                            const unsigned int *_vertexGroup=nullptr);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the projected size of a bounding sphere as a fraction of the viewport height
+  /// @param[in] _MV the model view matrix
+  /// @param[in] _project the projection matrix
+  /// @param[in] _centre the sphere centre in model space
+  /// @param[in] _radius the sphere radius in model space
+  //----------------------------------------------------------------------------------------------------------------------
+  extern float projectedSize(const ngl::Mat4 &_MV, const ngl::Mat4 &_project, const ngl::Vec3 &_centre, float _radius);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief choose a level from the projected size, each level is used for half the screen size of
+  /// the one before it
+  /// @param[in] _projectedSize the value from projectedSize
+  /// @param[in] _numLODs how many levels are available
+  //----------------------------------------------------------------------------------------------------------------------
+  extern size_t selectLOD(float _projectedSize, size_t _numLODs);
+}
+
+
+#endif
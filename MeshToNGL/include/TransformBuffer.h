@@ -0,0 +1,107 @@
+#ifndef TRANSFORMBUFFER_H_
+#define TRANSFORMBUFFER_H_
+
+#include <ngl/Types.h>
+#include <ngl/Mat4.h>
+#include <utility>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @class TransformBuffer
+/// @brief holds the world matrix and normal matrix of every scene node in a texture buffer so the shader
+/// can fetch them by draw id rather than having them uploaded as uniforms before each draw. Each node is
+/// 8 RGBA32F texels, the world matrix (one texel per column) followed by its inverse transpose
+//----------------------------------------------------------------------------------------------------------------------
+class TransformBuffer
+{
+  public :
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the vertex attribute the draw id is passed in, this is never enabled as an array so the
+    /// value set with setDrawID is used for every vertex and instance of the draw
+    //----------------------------------------------------------------------------------------------------------------------
+    static constexpr GLuint s_drawIDAttribute=7;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief changed runs with fewer than this many untouched nodes between them are uploaded as one write,
+    /// re-sending a few nodes is cheaper than another glBufferSubData
+    //----------------------------------------------------------------------------------------------------------------------
+    static constexpr size_t s_mergeGap=16;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief ctor creates the buffer and texture so we must have a valid GL context
+    //----------------------------------------------------------------------------------------------------------------------
+    TransformBuffer();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief dtor releases the GL resources
+    //----------------------------------------------------------------------------------------------------------------------
+    ~TransformBuffer();
+    TransformBuffer(const TransformBuffer &)=delete;
+    TransformBuffer &operator=(const TransformBuffer &)=delete;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief set the world matrix of a node, this is not sent to the GPU until the next upload. The normal
+    /// matrix is calculated here so it is only done when the node changes
+    /// @param[in] _id the draw id of the node, the buffer grows if this is past the end. Nodes past
+    /// maxNodes() can't be read by the shader so are ignored with a warning
+    /// @param[in] _world the new world matrix
+    //----------------------------------------------------------------------------------------------------------------------
+    void set(unsigned int _id, const ngl::Mat4 &_world);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the world matrix of a node
+    /// @param[in] _id the draw id of the node
+    //----------------------------------------------------------------------------------------------------------------------
+    const ngl::Mat4 &world(unsigned int _id) const { return m_matrices[_id * 2]; }
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief write the nodes changed since the last upload to the GPU, one write per run of changed nodes
+    /// (runs closer than s_mergeGap are sent together). If nothing has changed this does nothing so it is
+    /// fine to call every frame
+    //----------------------------------------------------------------------------------------------------------------------
+    void upload();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief bind the texture buffer ready for drawing
+    /// @param[in] _unit the texture unit to use, the samplerBuffer uniform should be set to this
+    //----------------------------------------------------------------------------------------------------------------------
+    void bind(GLuint _unit=0) const;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief set the draw id for the following draws
+    /// @param[in] _id the draw id of the node
+    //----------------------------------------------------------------------------------------------------------------------
+    static void setDrawID(unsigned int _id);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the number of nodes in the buffer
+    //----------------------------------------------------------------------------------------------------------------------
+    size_t size() const { return m_matrices.size() / 2; }
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the most nodes the shader can address, from GL_MAX_TEXTURE_BUFFER_SIZE
+    //----------------------------------------------------------------------------------------------------------------------
+    size_t maxNodes() const { return m_maxNodes; }
+
+  private :
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the buffer storing the matrices
+    //----------------------------------------------------------------------------------------------------------------------
+    GLuint m_buffer=0;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the texture used to view the buffer from the shader
+    //----------------------------------------------------------------------------------------------------------------------
+    GLuint m_texture=0;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the world and normal matrix of each node one after the other, the CPU copy of the buffer
+    //----------------------------------------------------------------------------------------------------------------------
+    std::vector<ngl::Mat4> m_matrices;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the number of matrices the GPU buffer has room for
+    //----------------------------------------------------------------------------------------------------------------------
+    size_t m_capacity=0;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the runs of nodes [first,end) that differ from what is on the GPU
+    //----------------------------------------------------------------------------------------------------------------------
+    std::vector<std::pair<size_t,size_t>> m_dirty;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief nodes the texture buffer can hold, queried once in the ctor
+    //----------------------------------------------------------------------------------------------------------------------
+    size_t m_maxNodes=0;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief set once we have warned about going over the limit
+    //----------------------------------------------------------------------------------------------------------------------
+    bool m_warned=false;
+};
+
+#endif
@@ -0,0 +1,85 @@
+#ifndef UNIFORMBINDING_H_
+#define UNIFORMBINDING_H_
+#include <ngl/Types.h>
+#include <ngl/Mat3.h>
+#include <ngl/Mat4.h>
+#include <ngl/Vec3.h>
+#include <ngl/Vec4.h>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @class UniformLocation
+/// @brief a uniform location looked up once when the program is loaded, set() is then a single glUniform
+/// call rather than the name lookup ShaderLib::setUniform does each time. The program must be in use
+/// when set() is called. A name the program doesn't have (or the compiler removed) gives an invalid
+/// location which GL ignores, as with setUniform.
+//----------------------------------------------------------------------------------------------------------------------
+class UniformLocation
+{
+  public :
+    UniformLocation()=default;
+    UniformLocation(GLuint _program, const char *_name);
+    void set(int _value) const;
+    void set(float _value) const;
+    void set(const ngl::Vec3 &_value) const;
+    void set(const ngl::Vec4 &_value) const;
+    void set(const ngl::Mat3 &_value) const;
+    void set(const ngl::Mat4 &_value) const;
+    bool isValid() const { return m_location >= 0; }
+
+  private :
+    GLint m_location=-1;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @class FrameUniforms
+/// @brief the camera and light for a frame in a std140 uniform block shared by every program that
+/// declares FrameBlock (see the vertex / fragment shaders). Fill in data() and call upload() once per frame,
+/// it is one buffer update however many programs and draws use it.
+//----------------------------------------------------------------------------------------------------------------------
+class FrameUniforms
+{
+  public :
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief matches the std140 layout of FrameBlock, everything is a vec4 or mat4 so there is no padding
+    //----------------------------------------------------------------------------------------------------------------------
+    struct Block
+    {
+      ngl::Mat4 MV;
+      ngl::Mat4 MVP;
+      ngl::Mat4 M;
+      /// @brief the inverse transpose of MV, a mat4 as a std140 mat3 is padded to 3 vec4s anyway
+      ngl::Mat4 normalMatrix;
+      ngl::Vec4 viewerPos;
+      ngl::Vec4 lightPosition;
+      ngl::Vec4 lightAmbient;
+      ngl::Vec4 lightDiffuse;
+      ngl::Vec4 lightSpecular;
+    };
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the uniform buffer binding point FrameBlock is attached to
+    //----------------------------------------------------------------------------------------------------------------------
+    static constexpr GLuint s_bindingPoint=0;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief create the buffer, needs a GL context
+    //----------------------------------------------------------------------------------------------------------------------
+    FrameUniforms();
+    ~FrameUniforms();
+    FrameUniforms(const FrameUniforms &)=delete;
+    FrameUniforms &operator=(const FrameUniforms &)=delete;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief point a program's FrameBlock at our binding point, call once after the program is linked
+    /// @returns false if the program has no FrameBlock
+    //----------------------------------------------------------------------------------------------------------------------
+    bool attach(GLuint _program) const;
+    Block &data() { return m_data; }
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief copy data() to the GPU and bind the buffer
+    //----------------------------------------------------------------------------------------------------------------------
+    void upload();
+
+  private :
+    Block m_data;
+    GLuint m_buffer=0;
+};
+
+#endif
@@ -5,10 +5,14 @@ layout (location = 0) in vec3 inVert;
 layout (location = 1) in vec3 inNormal;
 /// @brief the in uv
 layout (location = 2) in vec2 inUV;
+/// @brief per instance model matrix (uses locations 3-6)
+layout (location = 3) in mat4 inInstance;
+/// @brief which node is being drawn, this is a constant attribute set before each draw (see TransformBuffer)
+layout (location = 7) in uint inDrawID;
+/// @brief the world matrix then normal matrix of every node, one texel per column
+uniform samplerBuffer nodeTransforms;
 /// @brief flag to indicate if model has unit normals if not normalize
 uniform bool Normalize;
-// the eye position of the camera
-uniform vec3 viewerPos;
 /// @brief the current fragment normal for the vert being processed
 out vec3 fragmentNormal;
 
@@ -21,13 +25,17 @@ struct Lights
   vec4 ambient;
   vec4 diffuse;
   vec4 specular;
-  float constantAttenuation;
-  float spotCosCutoff;
-  float quadraticAttenuation;
-  float linearAttenuation;
 };
-// array of lights
-uniform Lights light;
+/// @brief the camera and light, shared by every program and updated once per frame (see FrameUniforms)
+layout (std140) uniform FrameBlock
+{
+  mat4 MV;
+  mat4 MVP;
+  mat4 M;
+  mat4 normalMatrix;
+  vec4 viewerPos;
+  Lights light;
+};
 // direction of the lights used for shading
 out vec3 lightDir;
 // out the blinn half vector
@@ -35,16 +43,26 @@ out vec3 halfVector;
 out vec3 eyeDirection;
 out vec3 vPosition;
 
-uniform mat4 MV;
-uniform mat4 MVP;
-uniform mat3 normalMatrix;
-uniform mat4 M;
 
 
+mat4 fetchMatrix(int _texel)
+{
+  return mat4(texelFetch(nodeTransforms,_texel),
+              texelFetch(nodeTransforms,_texel+1),
+              texelFetch(nodeTransforms,_texel+2),
+              texelFetch(nodeTransforms,_texel+3));
+}
+
 void main()
 {
+int node = int(inDrawID) * 8;
+mat4 world = fetchMatrix(node);
+mat4 worldNormal = fetchMatrix(node + 4);
+// place the vertex by its node then move it by this instance, the instances are rigid so the
+// upper 3x3 is fine for the normal
+vec4 instanceVert = inInstance * world * vec4(inVert,1.0);
 // calculate the fragments surface normal
-fragmentNormal = (normalMatrix*inNormal);
+fragmentNormal = (mat3(normalMatrix)*mat3(inInstance)*mat3(worldNormal)*inNormal);
 
 
 if (Normalize == true)
@@ -52,14 +70,14 @@ if (Normalize == true)
  fragmentNormal = normalize(fragmentNormal);
 }
 // calculate the vertex position
-gl_Position = MVP*vec4(inVert,1.0);
+gl_Position = MVP*instanceVert;
 
-vec4 worldPosition = M * vec4(inVert, 1.0);
-eyeDirection = normalize(viewerPos - worldPosition.xyz);
+vec4 worldPosition = M * instanceVert;
+eyeDirection = normalize(viewerPos.xyz - worldPosition.xyz);
 // Get vertex position in eye coordinates
 // Transform the vertex to eye co-ordinates for frag shader
 /// @brief the vertex in eye co-ordinates  homogeneous
-vec4 eyeCord=MV*vec4(inVert,1);
+vec4 eyeCord=MV*instanceVert;
 
 vPosition = eyeCord.xyz / eyeCord.w;;
 
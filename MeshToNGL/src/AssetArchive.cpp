@@ -0,0 +1,237 @@
+#include "AssetArchive.h"
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#ifndef _WIN32
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+namespace
+{
+  constexpr char s_magic[4] = {'A', 'I', 'P', 'K'};
+  constexpr uint32_t s_version = 1;
+  constexpr size_t s_headerSize = 16;
+  constexpr size_t s_alignment = 16;
+
+  template <typename T>
+  void put(std::string &o_out, T _value)
+  {
+    o_out.append(reinterpret_cast<const char *>(&_value), sizeof(T));
+  }
+
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief bounds checked read from the mapping, returns false if it would run off the end
+  //----------------------------------------------------------------------------------------------------------------------
+  template <typename T>
+  bool get(const uint8_t *_data, size_t _size, size_t &io_pos, T &o_value)
+  {
+    if (io_pos > _size || _size - io_pos < sizeof(T))
+    {
+      return false;
+    }
+    std::memcpy(&o_value, _data + io_pos, sizeof(T));
+    io_pos += sizeof(T);
+    return true;
+  }
+} // end anon namespace
+
+uint64_t AssetArchive::hash(const uint8_t *_data, size_t _size)
+{
+  uint64_t h = 14695981039346656037ull;
+  for (size_t i = 0; i < _size; ++i)
+  {
+    h ^= _data[i];
+    h *= 1099511628211ull;
+  }
+  return h;
+}
+
+std::string AssetArchive::normalise(const std::string &_path)
+{
+  std::vector<std::string> parts;
+  std::string part;
+  std::string path(_path);
+  for (auto &c : path)
+  {
+    c = (c == '\\') ? '/' : c;
+  }
+  std::istringstream in(path);
+  while (std::getline(in, part, '/'))
+  {
+    if (part.empty() || part == ".")
+    {
+      continue;
+    }
+    if (part == ".." && !parts.empty() && parts.back() != "..")
+    {
+      parts.pop_back();
+      continue;
+    }
+    parts.push_back(part);
+  }
+  std::string out;
+  for (auto &p : parts)
+  {
+    out += out.empty() ? p : "/" + p;
+  }
+  return out;
+}
+
+std::shared_ptr<AssetArchive> AssetArchive::open(const std::string &_fname)
+{
+  std::shared_ptr<AssetArchive> archive(new AssetArchive);
+#ifndef _WIN32
+  int fd = ::open(_fname.c_str(), O_RDONLY);
+  if (fd < 0)
+  {
+    std::cerr << "unable to open archive " << _fname << "\n";
+    return nullptr;
+  }
+  struct stat info;
+  if (fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(s_headerSize))
+  {
+    close(fd);
+    std::cerr << _fname << " is not an archive\n";
+    return nullptr;
+  }
+  archive->m_size = static_cast<size_t>(info.st_size);
+  void *mapping = mmap(nullptr, archive->m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED)
+  {
+    std::cerr << "unable to map archive " << _fname << "\n";
+    archive->m_size = 0;
+    return nullptr;
+  }
+  // files are pulled out as the loader asks for them
+  madvise(mapping, archive->m_size, MADV_RANDOM);
+  archive->m_data = static_cast<const uint8_t *>(mapping);
+#else
+  std::ifstream file(_fname, std::ios::binary);
+  if (!file)
+  {
+    std::cerr << "unable to open archive " << _fname << "\n";
+    return nullptr;
+  }
+  archive->m_buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+  archive->m_data = archive->m_buffer.data();
+  archive->m_size = archive->m_buffer.size();
+#endif
+  const uint8_t *data = archive->m_data;
+  size_t size = archive->m_size;
+  size_t pos = sizeof(s_magic);
+  uint32_t version;
+  uint64_t count;
+  if (size < s_headerSize || std::memcmp(data, s_magic, sizeof(s_magic)) != 0)
+  {
+    std::cerr << _fname << " is not an archive\n";
+    return nullptr;
+  }
+  get(data, size, pos, version);
+  get(data, size, pos, count);
+  if (version != s_version)
+  {
+    std::cerr << _fname << " is archive version " << version << " expected " << s_version << "\n";
+    return nullptr;
+  }
+  // every entry is at least the three uint64s and the name length, check the count fits before trusting
+  // it to size anything
+  constexpr size_t minimumEntrySize = 3 * sizeof(uint64_t) + sizeof(uint32_t);
+  if (count > (size - pos) / minimumEntrySize)
+  {
+    std::cerr << _fname << " has a corrupt index\n";
+    return nullptr;
+  }
+  archive->m_names.reserve(count);
+  archive->m_entries.reserve(count);
+  for (uint64_t i = 0; i < count; ++i)
+  {
+    uint64_t offset, length, hash;
+    uint32_t nameLength;
+    if (!get(data, size, pos, offset) || !get(data, size, pos, length) ||
+        !get(data, size, pos, hash) || !get(data, size, pos, nameLength) ||
+        size - pos < nameLength || offset > size || size - offset < length)
+    {
+      std::cerr << _fname << " has a corrupt index\n";
+      return nullptr;
+    }
+    std::string name(reinterpret_cast<const char *>(data + pos), nameLength);
+    pos += nameLength;
+    archive->m_entries[name] = {data + offset, static_cast<size_t>(length), hash};
+    archive->m_names.push_back(std::move(name));
+  }
+  return archive;
+}
+
+AssetArchive::~AssetArchive()
+{
+#ifndef _WIN32
+  if (m_data != nullptr)
+  {
+    munmap(const_cast<uint8_t *>(m_data), m_size);
+  }
+#endif
+}
+
+const AssetArchive::Entry *AssetArchive::find(const std::string &_name) const
+{
+  auto entry = m_entries.find(normalise(_name));
+  return entry == m_entries.end() ? nullptr : &entry->second;
+}
+
+bool AssetArchive::write(const std::string &_fname, const std::vector<std::pair<std::string, std::string>> &_files)
+{
+  // read everything first so we know where the data will go
+  std::vector<std::string> contents;
+  contents.reserve(_files.size());
+  size_t indexSize = 0;
+  for (auto &f : _files)
+  {
+    std::ifstream in(f.second, std::ios::binary);
+    if (!in)
+    {
+      std::cerr << "unable to read " << f.second << "\n";
+      return false;
+    }
+    contents.emplace_back(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    indexSize += 3 * sizeof(uint64_t) + sizeof(uint32_t) + normalise(f.first).size();
+  }
+  auto align = [](size_t _pos) { return (_pos + s_alignment - 1) & ~(s_alignment - 1); };
+
+  std::string header;
+  header.append(s_magic, sizeof(s_magic));
+  put(header, s_version);
+  put(header, static_cast<uint64_t>(_files.size()));
+  size_t offset = align(s_headerSize + indexSize);
+  for (size_t i = 0; i < _files.size(); ++i)
+  {
+    std::string name = normalise(_files[i].first);
+    put(header, static_cast<uint64_t>(offset));
+    put(header, static_cast<uint64_t>(contents[i].size()));
+    put(header, hash(reinterpret_cast<const uint8_t *>(contents[i].data()), contents[i].size()));
+    put(header, static_cast<uint32_t>(name.size()));
+    header += name;
+    offset = align(offset + contents[i].size());
+  }
+
+  std::ofstream out(_fname, std::ios::binary);
+  if (!out)
+  {
+    std::cerr << "unable to write " << _fname << "\n";
+    return false;
+  }
+  out.write(header.data(), static_cast<std::streamsize>(header.size()));
+  size_t pos = header.size();
+  for (auto &c : contents)
+  {
+    std::string padding(align(pos) - pos, '\0');
+    out.write(padding.data(), static_cast<std::streamsize>(padding.size()));
+    out.write(c.data(), static_cast<std::streamsize>(c.size()));
+    pos = align(pos) + c.size();
+  }
+  return static_cast<bool>(out);
+}
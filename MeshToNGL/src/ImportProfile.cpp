@@ -0,0 +1,162 @@
+#include "ImportProfile.h"
+#include <assimp/postprocess.h>
+#include <assimp/ProgressHandler.hpp>
+#include <chrono>
+#include <iostream>
+
+namespace ImportProfile
+{
+  namespace
+  {
+    struct Profile
+    {
+      const char *name;
+      unsigned int flags;
+    };
+
+    const Profile s_profiles[] = {
+        {"fast", aiProcessPreset_TargetRealtime_Fast | aiProcess_Triangulate},
+        {"balanced", aiProcessPreset_TargetRealtime_Quality | aiProcess_Triangulate},
+        {"max", aiProcessPreset_TargetRealtime_MaxQuality | aiProcess_Triangulate}};
+
+    struct Step
+    {
+      unsigned int flag;
+      const char *name;
+    };
+
+    // the order assimp's step registry runs them in, so applying them one at a time gives the
+    // same result as passing all the flags to ReadFile
+    const Step s_steps[] = {
+        {aiProcess_ValidateDataStructure, "ValidateDataStructure"},
+        {aiProcess_MakeLeftHanded, "MakeLeftHanded"},
+        {aiProcess_FlipUVs, "FlipUVs"},
+        {aiProcess_FlipWindingOrder, "FlipWindingOrder"},
+        {aiProcess_RemoveComponent, "RemoveComponent"},
+        {aiProcess_RemoveRedundantMaterials, "RemoveRedundantMaterials"},
+        {aiProcess_FindInstances, "FindInstances"},
+        {aiProcess_OptimizeGraph, "OptimizeGraph"},
+        {aiProcess_OptimizeMeshes, "OptimizeMeshes"},
+        {aiProcess_FindDegenerates, "FindDegenerates"},
+        {aiProcess_GenUVCoords, "GenUVCoords"},
+        {aiProcess_TransformUVCoords, "TransformUVCoords"},
+        {aiProcess_PreTransformVertices, "PreTransformVertices"},
+        {aiProcess_Triangulate, "Triangulate"},
+        {aiProcess_SortByPType, "SortByPType"},
+        {aiProcess_FindInvalidData, "FindInvalidData"},
+        {aiProcess_FixInfacingNormals, "FixInfacingNormals"},
+        {aiProcess_SplitByBoneCount, "SplitByBoneCount"},
+        {aiProcess_SplitLargeMeshes, "SplitLargeMeshes"},
+        {aiProcess_GenNormals, "GenNormals"},
+        {aiProcess_GenSmoothNormals, "GenSmoothNormals"},
+        {aiProcess_CalcTangentSpace, "CalcTangentSpace"},
+        {aiProcess_JoinIdenticalVertices, "JoinIdenticalVertices"},
+        {aiProcess_Debone, "Debone"},
+        {aiProcess_LimitBoneWeights, "LimitBoneWeights"},
+        {aiProcess_ImproveCacheLocality, "ImproveCacheLocality"}};
+
+    double msSince(std::chrono::steady_clock::time_point _start)
+    {
+      return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - _start).count();
+    }
+
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief assimp calls this as it loads, we use it to split the read into the parse (up to the last
+    /// UpdateFileRead) and the work assimp does after that (scene pre processing)
+    //----------------------------------------------------------------------------------------------------------------------
+    class StepTimer : public Assimp::ProgressHandler
+    {
+      public :
+        StepTimer() : m_start(std::chrono::steady_clock::now()) {}
+        bool Update(float) override { return true; }
+        void UpdateFileRead(int _currentStep, int _numberOfSteps) override
+        {
+          if (_currentStep >= _numberOfSteps)
+          {
+            m_parseMs = msSince(m_start);
+          }
+        }
+        double parseMs() const { return m_parseMs; }
+
+      private :
+        std::chrono::steady_clock::time_point m_start;
+        double m_parseMs = -1.0;
+    };
+  } // end anon namespace
+
+  bool flagsForProfile(const std::string &_name, unsigned int &o_flags)
+  {
+    for (auto &p : s_profiles)
+    {
+      if (_name == p.name)
+      {
+        o_flags = p.flags;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  const char *profileNames()
+  {
+    return "fast|balanced|max";
+  }
+
+  const aiScene *readFile(Assimp::Importer &_importer, const std::string &_fname, unsigned int _flags, bool _timeSteps)
+  {
+    if (!_timeSteps)
+    {
+      return _importer.ReadFile(_fname, _flags);
+    }
+    // the importer owns (and deletes) the handler
+    auto *timer = new StepTimer;
+    _importer.SetProgressHandler(timer);
+    auto start = std::chrono::steady_clock::now();
+    const aiScene *scene = _importer.ReadFile(_fname, 0);
+    double readMs = msSince(start);
+    if (scene == nullptr)
+    {
+      _importer.SetProgressHandler(nullptr);
+      return nullptr;
+    }
+    std::cout << "import " << _fname << "\n";
+    if (timer->parseMs() >= 0.0)
+    {
+      std::cout << "  parse " << timer->parseMs() << " ms\n";
+    }
+    std::cout << "  read " << readMs << " ms\n";
+    double total = readMs;
+    unsigned int remaining = _flags;
+    for (auto &step : s_steps)
+    {
+      if ((_flags & step.flag) == 0)
+      {
+        continue;
+      }
+      remaining &= ~step.flag;
+      auto stepStart = std::chrono::steady_clock::now();
+      scene = _importer.ApplyPostProcessing(step.flag);
+      double stepMs = msSince(stepStart);
+      total += stepMs;
+      std::cout << "  " << step.name << " " << stepMs << " ms\n";
+      if (scene == nullptr)
+      {
+        std::cerr << step.name << " failed\n";
+        break;
+      }
+    }
+    // anything we don't have a name for is applied in one go
+    if (scene != nullptr && remaining != 0)
+    {
+      auto stepStart = std::chrono::steady_clock::now();
+      scene = _importer.ApplyPostProcessing(remaining);
+      double stepMs = msSince(stepStart);
+      total += stepMs;
+      std::cout << "  other steps (0x" << std::hex << remaining << std::dec << ") " << stepMs << " ms\n";
+    }
+    std::cout << "  total " << total << " ms\n";
+    // back to the default (null) handler, this deletes ours
+    _importer.SetProgressHandler(nullptr);
+    return scene;
+  }
+}
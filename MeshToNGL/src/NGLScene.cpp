@@ -3,40 +3,72 @@
 
 #include "NGLScene.h"
 #include "AIUtil.h"
+#include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <numeric>
 #include <ngl/NGLInit.h>
 #include <ngl/NGLStream.h>
 #include <ngl/ShaderLib.h>
 #include <ngl/VAOFactory.h>
-#include <ngl/SimpleVAO.h>
+#include <ngl/SimpleIndexVAO.h>
 #include <assimp/cimport.h>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 #include <assimp/vector3.h>
+#include "ImportProfile.h"
+#include "ArchiveIOSystem.h"
+#include "MappedIOSystem.h"
+#include "Profiler.h"
+#include "ShaderCache.h"
+#include "UniformBinding.h"
+#include "RenderStats.h"
 
-NGLScene::NGLScene(const std::string &_fname)
+NGLScene::NGLScene(const std::string &_fname, size_t _numInstances, unsigned int _importFlags, bool _timeImport,
+                   std::shared_ptr<AssetArchive> _archive)
 {
+  m_numInstances = _numInstances;
+  m_timeImport = _timeImport;
   setTitle("Using libassimp with NGL simple Mesh");
   // the following code is modified from this
   // http://assimp.svn.sourceforge.net/viewvc/assimp/trunk/samples/SimpleOpenGL/
-  // we are taking one of the postprocessing presets to avoid
+  // we are taking one of the postprocessing presets (chosen on the command line) to avoid
   // spelling out 20+ single postprocessing flags here.
 
-  m_scene = aiImportFile(_fname.c_str(),
-                         aiProcessPreset_TargetRealtime_MaxQuality |
-                             aiProcess_Triangulate |
-                             aiProcess_PreTransformVertices |
-                             aiProcess_FixInfacingNormals);
+  // read models from the archive or through mmap rather than stdio, the importer owns (and deletes) the IO system
+  if (_archive)
+  {
+    m_importer.SetIOHandler(new ArchiveIOSystem(std::move(_archive)));
+  }
+  else
+  {
+    m_importer.SetIOHandler(new MappedIOSystem);
+  }
+  // the node hierarchy is kept, each node's world matrix goes in the transform buffer
+  m_scene = ImportProfile::readFile(m_importer, _fname,
+                                    _importFlags |
+                                        aiProcess_FixInfacingNormals,
+                                    _timeImport);
   if (m_scene == nullptr)
   {
-    std::cout << "error opening file " << _fname << "\n";
+    std::cout << "error opening file " << _fname << " " << m_importer.GetErrorString() << "\n";
     exit(EXIT_FAILURE);
   }
+  // the swap happens after paintGL returns so the frame is closed when Qt tells us it is done
+  connect(this, &QOpenGLWindow::frameSwapped, []() { PROFILE_END_FRAME(); });
 }
 
 NGLScene::~NGLScene()
 {
+  // the GL members are released after this body runs so make sure their context is current, in
+  // headless mode the window never made one and the renderer's context stays current instead
+  makeCurrent();
   std::cout << "Shutting down NGL, removing VAO's and Shaders\n";
+  if (m_instanceBuffer != 0)
+  {
+    glDeleteBuffers(1, &m_instanceBuffer);
+  }
+  PROFILE_WRITE_TRACE("profile.json");
 }
 
 void NGLScene::resizeGL(int _w, int _h)
@@ -45,6 +77,11 @@ void NGLScene::resizeGL(int _w, int _h)
   m_win.width = static_cast<int>(_w * devicePixelRatio());
   m_win.height = static_cast<int>(_h * devicePixelRatio());
 }
+void NGLScene::setFixedFrame(size_t _frame, size_t _numFrames)
+{
+  m_win.spinYFace = static_cast<int>((360 * _frame) / std::max<size_t>(_numFrames, 1));
+}
+
 void NGLScene::initializeGL()
 {
   // we must call this first before any other GL commands to load and link the
@@ -61,6 +98,15 @@ void NGLScene::initializeGL()
   // First create Values for the camera position
   ngl::Vec3 min, max;
   AIU::getSceneBoundingBox(m_scene, min, max);
+  // the instances are laid out on a square grid in x/z so grow the box to cover all of them
+  ngl::Vec3 size = max - min;
+  float spacing = std::max(size.m_x, size.m_z) * 1.2f;
+  buildInstanceBuffer(spacing);
+  float gridExtent = (std::ceil(std::sqrt(static_cast<float>(m_numInstances))) - 1.0f) * spacing * 0.5f;
+  min.m_x -= gridExtent;
+  min.m_z -= gridExtent;
+  max.m_x += gridExtent;
+  max.m_z += gridExtent;
   ngl::Vec3 center = (min + max) / 2.0f;
   ngl::Vec3 from;
   from.m_x = 0.0f;
@@ -75,50 +121,174 @@ void NGLScene::initializeGL()
   // we are creating a shader called Phong to save typos
   // in the code create some constexpr
   constexpr auto shaderProgram = "Phong";
-  constexpr auto vertexShader = "PhongVertex";
-  constexpr auto fragShader = "PhongFragment";
-  // create the shader program
-  ngl::ShaderLib::createShaderProgram(shaderProgram);
-  // now we are going to create empty shaders for Frag and Vert
-  ngl::ShaderLib::attachShader(vertexShader, ngl::ShaderType::VERTEX);
-  ngl::ShaderLib::attachShader(fragShader, ngl::ShaderType::FRAGMENT);
-  // attach the source
-  ngl::ShaderLib::loadShaderSource(vertexShader, "shaders/PhongVertex.glsl");
-  ngl::ShaderLib::loadShaderSource(fragShader, "shaders/PhongFragment.glsl");
-  // compile the shaders
-  ngl::ShaderLib::compileShader(vertexShader);
-  ngl::ShaderLib::compileShader(fragShader);
-  // add them to the program
-  ngl::ShaderLib::attachShaderToProgram(shaderProgram, vertexShader);
-  ngl::ShaderLib::attachShaderToProgram(shaderProgram, fragShader);
-
-  // now we have associated that data we can link the shader
-  ngl::ShaderLib::linkProgramObject(shaderProgram);
+  // build the program (PhongVertex / PhongFragment) from the binary cache or from source
+  ShaderCache::loadProgram(shaderProgram, "shaders/PhongVertex.glsl", "shaders/PhongFragment.glsl");
   // and make it active ready to load values
   ngl::ShaderLib::use(shaderProgram);
+  // the camera and light go in the shared uniform block, the matrices are filled in each frame
+  GLuint program = ngl::ShaderLib::getProgramID(shaderProgram);
+  m_frameUniforms = std::make_unique<FrameUniforms>();
+  m_frameUniforms->attach(program);
+  FrameUniforms::Block &frame = m_frameUniforms->data();
   ngl::Vec4 lightPos = from;
   ngl::Mat4 iv = m_view;
   iv.inverse().transpose();
-  ngl::ShaderLib::setUniform("light.position", lightPos * iv);
-  ngl::ShaderLib::setUniform("light.ambient", 0.1f, 0.1f, 0.1f, 1.0f);
-  ngl::ShaderLib::setUniform("light.diffuse", 1.0f, 1.0f, 1.0f, 1.0f);
-  ngl::ShaderLib::setUniform("light.specular", 0.8f, 0.8f, 0.8f, 1.0f);
-  // gold like phong material
-  ngl::ShaderLib::setUniform("material.ambient", 0.274725f, 0.1995f, 0.0745f, 0.0f);
-  ngl::ShaderLib::setUniform("material.diffuse", 0.75164f, 0.60648f, 0.22648f, 0.0f);
-  ngl::ShaderLib::setUniform("material.specular", 0.628281f, 0.555802f, 0.3666065f, 0.0f);
-  ngl::ShaderLib::setUniform("material.shininess", 51.2f);
-  ngl::ShaderLib::setUniform("viewerPos", from);
+  frame.lightPosition = lightPos * iv;
+  frame.lightAmbient = ngl::Vec4(0.1f, 0.1f, 0.1f, 1.0f);
+  frame.lightDiffuse = ngl::Vec4(1.0f, 1.0f, 1.0f, 1.0f);
+  frame.lightSpecular = ngl::Vec4(0.8f, 0.8f, 0.8f, 1.0f);
+  frame.viewerPos = ngl::Vec4(from, 1.0f);
+  // gold like phong material, this never changes so is set once
+  UniformLocation(program, "material.ambient").set(ngl::Vec4(0.274725f, 0.1995f, 0.0745f, 0.0f));
+  UniformLocation(program, "material.diffuse").set(ngl::Vec4(0.75164f, 0.60648f, 0.22648f, 0.0f));
+  UniformLocation(program, "material.specular").set(ngl::Vec4(0.628281f, 0.555802f, 0.3666065f, 0.0f));
+  UniformLocation(program, "material.shininess").set(51.2f);
+  // the node transforms are always on texture unit 0
+  UniformLocation(program, "nodeTransforms").set(0);
+  m_transforms = std::make_unique<TransformBuffer>();
 
   buildVAOFromScene();
   // as re-size is not explicitly called we need to do this.
   m_project = ngl::perspective(45.0f, static_cast<float>(width()) / height(), 0.5f, 550.0f);
 }
 
+void NGLScene::buildInstanceBuffer(float _spacing)
+{
+  // centre a square grid on the origin, the matrices are in the layout we upload as uniforms so
+  // each column becomes one vec4 attribute in the shader
+  size_t side = static_cast<size_t>(std::ceil(std::sqrt(static_cast<float>(m_numInstances))));
+  float offset = (side - 1) * _spacing * 0.5f;
+  m_instances.resize(m_numInstances);
+  for (size_t i = 0; i < m_numInstances; ++i)
+  {
+    m_instances[i] = ngl::Mat4::translate((i % side) * _spacing - offset, 0.0f, (i / side) * _spacing - offset);
+  }
+  // buildVAOFromScene sizes the buffer once it knows which meshes are used, this just gives the VAOs
+  // something to point at
+  glGenBuffers(1, &m_instanceBuffer);
+  glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+  glBufferData(GL_ARRAY_BUFFER, m_instances.size() * sizeof(ngl::Mat4), &m_instances[0].m_00, GL_STREAM_DRAW);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  std::cout << "drawing " << m_numInstances << " instances\n";
+}
+
 void NGLScene::buildVAOFromScene()
 {
+  // the converted vertex and index data is only needed until it is uploaded so comes from an arena
+  // that is freed in one go when we are done
+  LinearArena arena;
+  // each aiMesh is uploaded once, however many nodes reference it
+  m_geometry.resize(m_scene->mNumMeshes);
+  for (unsigned int i = 0; i < m_scene->mNumMeshes; ++i)
+  {
+    buildGeometry(m_scene->mMeshes[i], arena, m_geometry[i]);
+  }
+  recurseScene(m_scene, m_scene->mRootNode, SceneGraph::s_noParent);
+  // the shader can only fetch the transforms of so many nodes, rather than read past the end of the
+  // buffer drop the meshes of any nodes after that (m_meshes is in node order so these are the tail)
+  auto unreachable = std::lower_bound(m_meshes.begin(), m_meshes.end(), m_transforms->maxNodes(),
+                                      [](const meshItem &_m, size_t _node) { return _m.node < _node; });
+  if (unreachable != m_meshes.end())
+  {
+    std::cerr << "the scene has " << m_graph.size() << " nodes but GL_MAX_TEXTURE_BUFFER_SIZE only allows "
+              << m_transforms->maxNodes() << ", " << (m_meshes.end() - unreachable) << " mesh references are not drawn\n";
+    m_meshes.erase(unreachable, m_meshes.end());
+  }
+  // draw the references to the same mesh together so the VAO is only bound once for them
+  m_drawOrder.resize(m_meshes.size());
+  std::iota(m_drawOrder.begin(), m_drawOrder.end(), 0u);
+  std::stable_sort(m_drawOrder.begin(), m_drawOrder.end(), [this](unsigned int _a, unsigned int _b)
+                   { return m_meshes[_a].geometry < m_meshes[_b].geometry; });
+  // every referenced mesh gets one copy of the grid in the instance buffer which all its references
+  // draw from, so the buffer grows with the unique meshes rather than the references
+  unsigned int numInstances = 0;
+  for (unsigned int i = 0; i < m_drawOrder.size(); ++i)
+  {
+    meshGeometry &geometry = m_geometry[m_meshes[m_drawOrder[i]].geometry];
+    if (geometry.numRefs++ == 0)
+    {
+      geometry.firstRef = i;
+      geometry.firstInstance = numInstances;
+      numInstances += static_cast<unsigned int>(m_numInstances);
+    }
+  }
+  m_frameInstances.resize(numInstances);
+  // no copy has a LOD yet so the first buildLODDraws uploads everything
+  m_instanceLODs.assign(numInstances, Simplify::s_maxLODs);
+  glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+  glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(numInstances * sizeof(ngl::Mat4)), nullptr, GL_DYNAMIC_DRAW);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  updateTransforms();
+  if (m_timeImport)
+  {
+    auto &stats = arena.stats();
+    std::cout << "load scratch " << stats.allocations << " allocations " << stats.bytes / 1024 << " KB from "
+              << stats.blocks << " heap blocks\n";
+  }
+  std::cout << m_meshes.size() << " mesh references to " << m_geometry.size() << " unique meshes\n";
+}
+
+void NGLScene::updateTransforms()
+{
+  if (!m_graph.update(m_movedNodes))
+  {
+    return;
+  }
+  // only the subtrees that moved are set, so a node's normal matrix is only inverted when it changes
+  for (auto &range : m_movedNodes)
+  {
+    for (unsigned int n = range.first; n < range.end; ++n)
+    {
+      m_transforms->set(n, m_graph.world(n));
+    }
+    updateMeshBounds(range.first, range.end);
+  }
+  updateGeometryBounds();
+  m_lodsDirty = true;
+}
+
+void NGLScene::updateMeshBounds(unsigned int _first, unsigned int _end)
+{
+  // the meshes are in node order so the ones in a subtree are a contiguous run
+  auto begin = std::lower_bound(m_meshes.begin(), m_meshes.end(), _first,
+                                [](const meshItem &_m, unsigned int _node) { return _m.node < _node; });
+  for (auto m = begin; m != m_meshes.end() && m->node < _end; ++m)
+  {
+    const ngl::Mat4 &world = m_graph.world(m->node);
+    const meshGeometry &geometry = m_geometry[m->geometry];
+    // scale the radius by the largest axis scale so the sphere still bounds the mesh
+    float scale = 0.0f;
+    for (int c = 0; c < 3; ++c)
+    {
+      scale = std::max(scale, ngl::Vec3(world.m_m[c][0], world.m_m[c][1], world.m_m[c][2]).length());
+    }
+    m->centre = (world * ngl::Vec4(geometry.localCentre, 1.0f)).toVec3();
+    m->radius = geometry.localRadius * scale;
+  }
+}
 
-  recurseScene(m_scene, m_scene->mRootNode, ngl::Mat4(1.0));
+void NGLScene::updateGeometryBounds()
+{
+  for (auto &geometry : m_geometry)
+  {
+    if (geometry.numRefs == 0)
+    {
+      continue;
+    }
+    // the box around every reference's sphere, then the sphere around that
+    ngl::Vec3 min(1e10f, 1e10f, 1e10f);
+    ngl::Vec3 max(-1e10f, -1e10f, -1e10f);
+    for (unsigned int r = geometry.firstRef; r < geometry.firstRef + geometry.numRefs; ++r)
+    {
+      const meshItem &m = m_meshes[m_drawOrder[r]];
+      min.set(std::min(min.m_x, m.centre.m_x - m.radius), std::min(min.m_y, m.centre.m_y - m.radius),
+              std::min(min.m_z, m.centre.m_z - m.radius));
+      max.set(std::max(max.m_x, m.centre.m_x + m.radius), std::max(max.m_y, m.centre.m_y + m.radius),
+              std::max(max.m_z, m.centre.m_z + m.radius));
+    }
+    geometry.centre = (min + max) * 0.5f;
+    geometry.radius = (max - min).length() * 0.5f;
+  }
 }
 
 // a simple structure to hold our vertex data
@@ -134,105 +304,242 @@ struct vertData
   GLfloat v;
 };
 
-void NGLScene::recurseScene(const aiScene *sc, const aiNode *nd, const ngl::Mat4 &_parentTx)
+// copy every LOD one after another into o_packed at the width of T
+template <typename T>
+static void packLODs(const std::vector<std::vector<GLuint>> &_lods, ArenaVector<T> &o_packed)
 {
-  ngl::Mat4 m = AIU::aiMatrix4x4ToNGLMat4Transpose(nd->mTransformation);
+  for (auto &lod : _lods)
+  {
+    o_packed.insert(o_packed.end(), lod.begin(), lod.end());
+  }
+}
 
-  unsigned int n = 0, t;
-  std::vector<vertData> verts;
-  vertData v;
-  meshItem thisMesh;
-  // the transform is relative to the parent node so we accumulate
-  thisMesh.tx = m * _parentTx;
+void NGLScene::buildGeometry(const aiMesh *_mesh, LinearArena &_arena, meshGeometry &o_geometry)
+{
+  // we pass the assimp positions straight to the simplifier so they must be packed floats
+  static_assert(sizeof(aiVector3D) == 3 * sizeof(float), "assimp must be built with float precision");
+  // the face list and LODs go to Simplify so are normal vectors, the rest is in the arena
+  std::vector<GLuint> indices;
+  std::vector<std::vector<GLuint>> lods;
+  unsigned int t;
 
-  for (; n < nd->mNumMeshes; ++n)
+  // copy the unique vertices once, the faces index into these
+  ArenaVector<vertData> verts(_mesh->mNumVertices, _arena);
+  ngl::Vec3 min(1e10f, 1e10f, 1e10f);
+  ngl::Vec3 max(-1e10f, -1e10f, -1e10f);
+  for (t = 0; t < _mesh->mNumVertices; ++t)
   {
-    verts.clear();
-    const aiMesh *mesh = m_scene->mMeshes[nd->mMeshes[n]];
-
-    thisMesh.vao = ngl::VAOFactory::createVAO(ngl::simpleVAO, GL_TRIANGLES);
-    for (t = 0; t < mesh->mNumFaces; ++t)
+    vertData &v = verts[t];
+    v.x = _mesh->mVertices[t].x;
+    v.y = _mesh->mVertices[t].y;
+    v.z = _mesh->mVertices[t].z;
+    v.nx = v.ny = v.nz = 0.0f;
+    v.u = v.v = 0.0f;
+    if (_mesh->mNormals != nullptr)
     {
-      const aiFace *face = &mesh->mFaces[t];
-      // only deal with triangles for ease
-      if (face->mNumIndices != 3)
-      {
-        std::cout << "mesh size not tri" << face->mNumIndices << "\n";
-        break;
-      }
-      for (unsigned int i = 0; i < face->mNumIndices; i++)
-      {
-        unsigned int index = face->mIndices[i];
+      v.nx = _mesh->mNormals[t].x;
+      v.ny = _mesh->mNormals[t].y;
+      v.nz = _mesh->mNormals[t].z;
+    }
+    if (_mesh->HasTextureCoords(0))
+    {
+      v.u = _mesh->mTextureCoords[0][t].x;
+      v.v = _mesh->mTextureCoords[0][t].y;
+    }
+    min.set(std::min(min.m_x, v.x), std::min(min.m_y, v.y), std::min(min.m_z, v.z));
+    max.set(std::max(max.m_x, v.x), std::max(max.m_y, v.y), std::max(max.m_z, v.z));
+  }
+  indices.reserve(_mesh->mNumFaces * 3);
+  for (t = 0; t < _mesh->mNumFaces; ++t)
+  {
+    const aiFace *face = &_mesh->mFaces[t];
+    // only deal with triangles for ease
+    if (face->mNumIndices != 3)
+    {
+      std::cout << "mesh size not tri" << face->mNumIndices << "\n";
+      break;
+    }
+    indices.insert(indices.end(), face->mIndices, face->mIndices + 3);
+  }
+  if (indices.empty())
+  {
+    return;
+  }
+  // build the LOD chain from the indexed data and pack every level into one index buffer
+  // so they all share the same vertices
+  Simplify::buildLODChain(&_mesh->mVertices[0].x, _mesh->mNumVertices, 3, indices, lods);
+  o_geometry.numLODs = lods.size();
+  unsigned int numIndices = 0;
+  for (size_t l = 0; l < lods.size(); ++l)
+  {
+    o_geometry.lodBase[l] = numIndices;
+    o_geometry.lodCount[l] = static_cast<unsigned int>(lods[l].size());
+    numIndices += o_geometry.lodCount[l];
+  }
+  // 16 bit indices reach every vertex of most meshes and halve the index buffer, only one of
+  // these is filled
+  ArenaVector<GLushort> packedShort(_arena);
+  ArenaVector<GLuint> packedInt(_arena);
+  const GLvoid *packed = nullptr;
+  if (_mesh->mNumVertices <= 65536)
+  {
+    o_geometry.indexType = GL_UNSIGNED_SHORT;
+    packedShort.reserve(numIndices);
+    packLODs(lods, packedShort);
+    packed = packedShort.data();
+  }
+  else
+  {
+    o_geometry.indexType = GL_UNSIGNED_INT;
+    packedInt.reserve(numIndices);
+    packLODs(lods, packedInt);
+    packed = packedInt.data();
+  }
+  o_geometry.localCentre = (min + max) * 0.5f;
+  o_geometry.localRadius = (max - min).length() * 0.5f;
 
-        if (mesh->mNormals != nullptr)
-        {
-          v.nx = mesh->mNormals[index].x;
-          v.ny = mesh->mNormals[index].y;
-          v.nz = mesh->mNormals[index].z;
-        }
-        if (mesh->HasTextureCoords(0))
-        {
-          v.u = mesh->mTextureCoords[0]->x;
-          v.v = mesh->mTextureCoords[0]->y;
-        }
-        v.x = mesh->mVertices[index].x;
-        v.y = mesh->mVertices[index].y;
-        v.z = mesh->mVertices[index].z;
-        verts.push_back(v);
-      }
+  o_geometry.vao = ngl::VAOFactory::createVAO(ngl::simpleIndexVAO, GL_TRIANGLES);
+  o_geometry.vao->bind();
+  // now we have our data add it to the VAO, we need to tell the VAO the following
+  // how much (in bytes) data we are copying
+  // a pointer to the first element of data (in this case the address of the first element of the
+  // std::vector
+  // and the same for the indices
+  o_geometry.vao->setData(ngl::SimpleIndexVAO::VertexData(verts.size() * sizeof(vertData), verts[0].x,
+                                                          numIndices, packed, o_geometry.indexType));
+  // in this case we have packed our data in interleaved format as follows
+  // x,y,z,nx,ny,nz,u,v
+  // If you look at the shader we have the following attributes being used
+  // attribute vec3 inVert; attribute 0
+  // attribute vec3 inNormal; attribure 1
+  // attribute vec2 inUV; attribute 2
+  o_geometry.vao->setVertexAttributePointer(0, 3, GL_FLOAT, sizeof(vertData), 0);
+  o_geometry.vao->setVertexAttributePointer(1, 3, GL_FLOAT, sizeof(vertData), 3);
+  o_geometry.vao->setVertexAttributePointer(2, 2, GL_FLOAT, sizeof(vertData), 6);
+  // the per instance model matrix is a mat4 so takes attributes 3,4,5 and 6, these only
+  // advance once per instance rather than per vertex
+  glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+  for (GLuint c = 0; c < 4; ++c)
+  {
+    glVertexAttribPointer(3 + c, 4, GL_FLOAT, GL_FALSE, sizeof(ngl::Mat4),
+                          reinterpret_cast<GLvoid *>(c * 4 * sizeof(GLfloat)));
+    glEnableVertexAttribArray(3 + c);
+    glVertexAttribDivisor(3 + c, 1);
+  }
+  o_geometry.vao->setNumIndices(o_geometry.lodCount[0]);
+  // finally we have finished for now so time to unbind the VAO
+  o_geometry.vao->unbind();
+}
+
+void NGLScene::recurseScene(const aiScene *sc, const aiNode *nd, unsigned int _parent)
+{
+  ngl::Mat4 m = AIU::aiMatrix4x4ToNGLMat4Transpose(nd->mTransformation);
+  // the transform is relative to the parent node, the world matrices are worked out by the graph
+  unsigned int node = m_graph.addNode(_parent, m);
+
+  // every mesh is already uploaded so a reference is just the node and the mesh index
+  for (unsigned int n = 0; n < nd->mNumMeshes; ++n)
+  {
+    if (m_geometry[nd->mMeshes[n]].vao == nullptr)
+    {
+      continue;
     }
-    thisMesh.vao->bind();
-    // now we have our data add it to the VAO, we need to tell the VAO the following
-    // how much (in bytes) data we are copying
-    // a pointer to the first element of data (in this case the address of the first element of the
-    // std::vector
-    thisMesh.vao->setData(ngl::AbstractVAO::VertexData(verts.size() * sizeof(vertData), verts[0].x));
-    // in this case we have packed our data in interleaved format as follows
-    // u,v,nx,ny,nz,x,y,z
-    // If you look at the shader we have the following attributes being used
-    // attribute vec3 inVert; attribute 0
-    // attribute vec3 inNormal; attribure 1
-    // attribute vec2 inUV; attribute 2
-    thisMesh.vao->setVertexAttributePointer(0, 3, GL_FLOAT, sizeof(vertData), 0);
-    thisMesh.vao->setVertexAttributePointer(1, 3, GL_FLOAT, sizeof(vertData), 3);
-    thisMesh.vao->setVertexAttributePointer(2, 2, GL_FLOAT, sizeof(vertData), 6);
-    thisMesh.vao->setNumIndices(verts.size());
-    // finally we have finished for now so time to unbind the VAO
-    thisMesh.vao->unbind();
-    m_meshes.emplace_back(std::move(thisMesh));
+    meshItem thisMesh;
+    thisMesh.node = node;
+    thisMesh.geometry = nd->mMeshes[n];
+    m_meshes.push_back(thisMesh);
   }
 
   // draw all children
-  for (n = 0; n < nd->mNumChildren; ++n)
+  for (unsigned int n = 0; n < nd->mNumChildren; ++n)
   {
-    recurseScene(sc, nd->mChildren[n], thisMesh.tx);
+    recurseScene(sc, nd->mChildren[n], node);
   }
 }
 
-void NGLScene::loadMatricesToShader()
+void NGLScene::buildLODDraws(const ngl::Mat4 &_MV)
 {
+  // the grid is fixed so the LODs only change when the camera or a node moves
+  if (!m_lodsDirty && std::equal(&_MV.m_00, &_MV.m_00 + 16, &m_lodMV.m_00))
+  {
+    return;
+  }
+  PROFILE_CPU("selectLODs");
+  m_lodsDirty = false;
+  m_lodMV = _MV;
+  m_lodDraws.clear();
+  glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+  for (unsigned int g = 0; g < m_geometry.size(); ++g)
+  {
+    const meshGeometry &geometry = m_geometry[g];
+    if (geometry.numRefs == 0)
+    {
+      continue;
+    }
+    // each copy is only translated so its bounds are the mesh's moved by the grid offset, copies
+    // far from the camera drop detail on their own
+    unsigned int *lods = &m_instanceLODs[geometry.firstInstance];
+    std::array<unsigned int, Simplify::s_maxLODs> counts;
+    counts.fill(0);
+    bool changed = false;
+    for (size_t i = 0; i < m_numInstances; ++i)
+    {
+      const ngl::Mat4 &instance = m_instances[i];
+      ngl::Vec3 centre = geometry.centre + ngl::Vec3(instance.m_m[3][0], instance.m_m[3][1], instance.m_m[3][2]);
+      auto lod = static_cast<unsigned int>(
+          Simplify::selectLOD(Simplify::projectedSize(_MV, m_project, centre, geometry.radius), geometry.numLODs));
+      changed |= lods[i] != lod;
+      lods[i] = lod;
+      ++counts[lod];
+    }
+    // a counting sort puts the copies at each LOD next to each other, one draw per LOD in use
+    std::array<unsigned int, Simplify::s_maxLODs> next;
+    unsigned int first = geometry.firstInstance;
+    for (unsigned int lod = 0; lod < geometry.numLODs; ++lod)
+    {
+      next[lod] = first;
+      if (counts[lod] != 0)
+      {
+        m_lodDraws.push_back({g, lod, first, counts[lod]});
+      }
+      first += counts[lod];
+    }
+    if (!changed)
+    {
+      continue;
+    }
+    for (size_t i = 0; i < m_numInstances; ++i)
+    {
+      m_frameInstances[next[lods[i]]++] = m_instances[i];
+    }
+    auto bytes = static_cast<GLsizeiptr>(m_numInstances * sizeof(ngl::Mat4));
+    glBufferSubData(GL_ARRAY_BUFFER, static_cast<GLintptr>(geometry.firstInstance * sizeof(ngl::Mat4)), bytes,
+                    &m_frameInstances[geometry.firstInstance].m_00);
+    RenderStats::addBufferBytes(static_cast<size_t>(bytes));
+  }
+}
 
-  ngl::Mat4 MV;
-  ngl::Mat4 MVP;
-  ngl::Mat3 normalMatrix;
-  ngl::Mat4 M;
-  M = m_mouseGlobalTX * m_transform.getMatrix();
-  MV = m_view * M;
-  MVP = m_project * MV;
-  normalMatrix = MV;
-  normalMatrix.inverse().transpose();
-  ngl::ShaderLib::setUniform("MV", MV);
-  ngl::ShaderLib::setUniform("MVP", MVP);
-  ngl::ShaderLib::setUniform("normalMatrix", normalMatrix);
-  ngl::ShaderLib::setUniform("M", M);
+void NGLScene::loadMatricesToShader()
+{
+  // one buffer update for the whole frame rather than a uniform call (and name lookup) per matrix
+  FrameUniforms::Block &frame = m_frameUniforms->data();
+  frame.M = m_mouseGlobalTX * m_transform.getMatrix();
+  frame.MV = m_view * frame.M;
+  frame.MVP = m_project * frame.MV;
+  frame.normalMatrix = frame.MV;
+  frame.normalMatrix.inverse().transpose();
+  m_frameUniforms->upload();
 }
 
 void NGLScene::paintGL()
 {
+  PROFILE_BEGIN_FRAME();
+  RenderStats::beginFrame();
   // clear the screen and depth buffer
   glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
   glViewport(0, 0, m_win.width, m_win.height);
   ngl::ShaderLib::use("Phong");
+  RenderStats::addProgramSwitch();
 
   // Rotation based on the mouse position for our global transform
   ngl::Transformation trans;
@@ -245,15 +552,53 @@ void NGLScene::paintGL()
   m_mouseGlobalTX.m_m[3][1] = m_modelPos.m_y;
   m_mouseGlobalTX.m_m[3][2] = m_modelPos.m_z;
   // set this in the TX stack
-  for (auto &m : m_meshes)
+  ngl::Mat4 MV = m_view * m_mouseGlobalTX * m_transform.getMatrix();
   {
-    ngl::Transformation t;
-    t.setMatrix(m.tx);
+    // the camera is the same for every mesh, the node matrices come from the transform buffer
+    PROFILE_CPU("uploadUniforms");
     loadMatricesToShader();
-    m.vao->bind();
-    m.vao->draw();
-    m.vao->unbind();
+    // the node matrices only go to the GPU when they have changed
+    updateTransforms();
+    m_transforms->upload();
   }
+  m_transforms->bind(0);
+  buildLODDraws(MV);
+  glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+  // the draws are sorted by mesh so the VAO only changes between different meshes
+  const meshGeometry *bound = nullptr;
+  for (auto &draw : m_lodDraws)
+  {
+    const meshGeometry &geometry = m_geometry[draw.geometry];
+    if (bound != &geometry)
+    {
+      geometry.vao->bind();
+      RenderStats::addVAOBind();
+      bound = &geometry;
+    }
+    // point the instance matrix at this group's range of the buffer, every reference draws from it
+    for (GLuint c = 0; c < 4; ++c)
+    {
+      glVertexAttribPointer(3 + c, 4, GL_FLOAT, GL_FALSE, sizeof(ngl::Mat4),
+                            reinterpret_cast<GLvoid *>(draw.first * sizeof(ngl::Mat4) + c * 4 * sizeof(GLfloat)));
+    }
+    size_t indexSize = geometry.indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+    for (unsigned int r = geometry.firstRef; r < geometry.firstRef + geometry.numRefs; ++r)
+    {
+      PROFILE_CPU("drawMesh");
+      PROFILE_GPU("drawMesh");
+      TransformBuffer::setDrawID(m_meshes[m_drawOrder[r]].node);
+      glDrawElementsInstanced(GL_TRIANGLES, geometry.lodCount[draw.lod], geometry.indexType,
+                              reinterpret_cast<GLvoid *>(indexSize * geometry.lodBase[draw.lod]),
+                              static_cast<GLsizei>(draw.count));
+      RenderStats::addDraw(geometry.lodCount[draw.lod], draw.count);
+    }
+  }
+  if (bound != nullptr)
+  {
+    bound->vao->unbind();
+  }
+  RenderStats::endFrame();
+  PROFILE_BEGIN_SWAP();
 }
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -284,6 +629,27 @@ void NGLScene::keyPressEvent(QKeyEvent *_event)
   case Qt::Key_N:
     showNormal();
     break;
+  // dump the last few seconds of profile data
+  case Qt::Key_P:
+    PROFILE_WRITE_TRACE("profile.json");
+    break;
+  // select the next node to edit
+  case Qt::Key_Tab:
+    m_selectedNode = static_cast<unsigned int>((m_selectedNode + 1) % std::max<size_t>(m_graph.size(), 1));
+    std::cout << "selected node " << m_selectedNode << " " << m_graph.subtreeEnd(m_selectedNode) - m_selectedNode - 1
+              << " children\n";
+    break;
+  // spin the selected node (and everything under it) about its y axis
+  case Qt::Key_R:
+    m_graph.setLocal(m_selectedNode, m_graph.local(m_selectedNode) * ngl::Mat4::rotateY(10.0f));
+    break;
+  // raise and lower the selected node
+  case Qt::Key_Up:
+    m_graph.setLocal(m_selectedNode, ngl::Mat4::translate(0.0f, 0.1f, 0.0f) * m_graph.local(m_selectedNode));
+    break;
+  case Qt::Key_Down:
+    m_graph.setLocal(m_selectedNode, ngl::Mat4::translate(0.0f, -0.1f, 0.0f) * m_graph.local(m_selectedNode));
+    break;
   default:
     break;
   }
@@ -0,0 +1,181 @@
+#include "Profiler.h"
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+
+std::array<Profiler::Frame,Profiler::s_historySize> Profiler::s_frames;
+uint64_t Profiler::s_frameIndex=0;
+double Profiler::s_swapStart=-1.0;
+bool Profiler::s_gpuScopeActive=false;
+std::array<std::vector<Profiler::PendingQuery>,2> Profiler::s_pending;
+std::vector<GLuint> Profiler::s_freeQueries;
+
+double Profiler::now()
+{
+  // everything is relative to the first call so the trace starts at 0
+  static const auto s_start=std::chrono::steady_clock::now();
+  return std::chrono::duration<double,std::micro>(std::chrono::steady_clock::now()-s_start).count();
+}
+
+Profiler::Frame &Profiler::current()
+{
+  return s_frames[s_frameIndex % s_historySize];
+}
+
+void Profiler::record(const char *_name, double _start, double _duration, bool _gpu)
+{
+  current().events.push_back({_name,_start,_duration,_gpu});
+}
+
+Profiler::CPUScope::CPUScope(const char *_name) : m_name(_name), m_start(Profiler::now())
+{
+}
+
+Profiler::CPUScope::~CPUScope()
+{
+  double end=Profiler::now();
+  Profiler::record(m_name,m_start,end-m_start,false);
+}
+
+Profiler::GPUScope::GPUScope(const char *_name)
+{
+  // GL_TIME_ELAPSED queries can't be nested
+  if(s_gpuScopeActive)
+  {
+    return;
+  }
+  GLuint query;
+  if(s_freeQueries.empty())
+  {
+    glGenQueries(1,&query);
+  }
+  else
+  {
+    query=s_freeQueries.back();
+    s_freeQueries.pop_back();
+  }
+  glBeginQuery(GL_TIME_ELAPSED,query);
+  Frame &frame=current();
+  s_pending[s_frameIndex & 1].push_back({query,s_frameIndex,frame.events.size()});
+  frame.events.push_back({_name,Profiler::now(),-1.0,true});
+  s_gpuScopeActive=true;
+  m_active=true;
+}
+
+Profiler::GPUScope::~GPUScope()
+{
+  if(m_active)
+  {
+    glEndQuery(GL_TIME_ELAPSED);
+    s_gpuScopeActive=false;
+  }
+}
+
+void Profiler::resolveQueries(size_t _set)
+{
+  for(auto &p : s_pending[_set])
+  {
+    Frame &frame=s_frames[p.frame % s_historySize];
+    GLint available=0;
+    glGetQueryObjectiv(p.query,GL_QUERY_RESULT_AVAILABLE,&available);
+    // the frame may have been overwritten if we have not been called for a while
+    if(available && frame.index==p.frame)
+    {
+      GLuint64 ns=0;
+      glGetQueryObjectui64v(p.query,GL_QUERY_RESULT,&ns);
+      double us=static_cast<double>(ns)/1000.0;
+      frame.events[p.event].duration=us;
+      frame.gpuMs+=us/1000.0;
+    }
+    // if the result is not ready we drop it rather than wait, the query object can be re-used
+    // as beginning a new query discards the old result
+    s_freeQueries.push_back(p.query);
+  }
+  if(!s_pending[_set].empty())
+  {
+    s_frames[s_pending[_set].front().frame % s_historySize].gpuResolved=true;
+  }
+  s_pending[_set].clear();
+}
+
+void Profiler::beginFrame()
+{
+  ++s_frameIndex;
+  // the queries in this set were issued two frames ago so should be ready by now
+  resolveQueries(s_frameIndex & 1);
+  Frame &frame=current();
+  frame.index=s_frameIndex;
+  frame.start=now();
+  frame.cpuMs=0.0;
+  frame.gpuMs=0.0;
+  frame.gpuResolved=false;
+  // clear keeps the capacity so after the first trip round the ring we don't allocate
+  frame.events.clear();
+  s_swapStart=-1.0;
+}
+
+void Profiler::beginSwap()
+{
+  s_swapStart=now();
+}
+
+void Profiler::endFrame()
+{
+  double end=now();
+  if(s_swapStart>=0.0)
+  {
+    record("swapBuffers",s_swapStart,end-s_swapStart,false);
+    s_swapStart=-1.0;
+  }
+  Frame &frame=current();
+  frame.cpuMs=(end-frame.start)/1000.0;
+}
+
+const Profiler::Frame &Profiler::frame(size_t _framesAgo)
+{
+  assert(_framesAgo < s_historySize);
+  return s_frames[(s_frameIndex - _framesAgo) % s_historySize];
+}
+
+size_t Profiler::historySize()
+{
+  return static_cast<size_t>(std::min<uint64_t>(s_frameIndex,s_historySize));
+}
+
+bool Profiler::writeChromeTrace(const std::string &_fname)
+{
+  std::ofstream out(_fname);
+  if(!out)
+  {
+    std::cerr<<"Profiler unable to write "<<_fname<<"\n";
+    return false;
+  }
+  out<<"{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+  out<<"{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"CPU\"}},\n";
+  out<<"{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"GPU\"}}";
+  auto writeEvent=[&out](const char *_name, double _start, double _duration, int _tid)
+  {
+    out<<",\n{\"name\":\""<<_name<<"\",\"cat\":\""<<(_tid==1 ? "cpu" : "gpu")
+       <<"\",\"ph\":\"X\",\"ts\":"<<_start<<",\"dur\":"<<_duration
+       <<",\"pid\":1,\"tid\":"<<_tid<<"}";
+  };
+  // oldest first
+  for(size_t i=historySize(); i-- > 0; )
+  {
+    const Frame &f=frame(i);
+    writeEvent("frame",f.start,f.cpuMs*1000.0,1);
+    for(auto &e : f.events)
+    {
+      // GPU scopes have no start time of their own so are shown from when they were issued
+      if(e.duration>=0.0)
+      {
+        writeEvent(e.name,e.start,e.duration,e.gpu ? 2 : 1);
+      }
+    }
+  }
+  out<<"\n]}\n";
+  std::cout<<"Profiler wrote "<<historySize()<<" frames to "<<_fname<<"\n";
+  return true;
+}
@@ -0,0 +1,69 @@
+#include "SceneGraph.h"
+#include <algorithm>
+#include <cassert>
+
+unsigned int SceneGraph::addNode(unsigned int _parent, const ngl::Mat4 &_local)
+{
+  auto node = static_cast<unsigned int>(m_local.size());
+  // depth first means the parent's subtree must still be the last one added
+  assert(_parent == s_noParent || (_parent < node && m_subtreeEnd[_parent] == node));
+  m_parent.push_back(_parent);
+  m_subtreeEnd.push_back(node + 1);
+  m_local.push_back(_local);
+  m_world.push_back(_local);
+  m_dirty.push_back(true);
+  m_dirtyNodes.push_back(node);
+  // the new node extends every subtree it is in
+  for (unsigned int p = _parent; p != s_noParent; p = m_parent[p])
+  {
+    m_subtreeEnd[p] = node + 1;
+  }
+  return node;
+}
+
+void SceneGraph::setLocal(unsigned int _node, const ngl::Mat4 &_local)
+{
+  m_local[_node] = _local;
+  if (!m_dirty[_node])
+  {
+    m_dirty[_node] = true;
+    m_dirtyNodes.push_back(_node);
+  }
+}
+
+bool SceneGraph::update(std::vector<Range> &o_ranges)
+{
+  o_ranges.clear();
+  if (m_dirtyNodes.empty())
+  {
+    return false;
+  }
+  // in index order a changed node inside a subtree we have just done is already up to date
+  std::sort(m_dirtyNodes.begin(), m_dirtyNodes.end());
+  for (auto node : m_dirtyNodes)
+  {
+    if (!o_ranges.empty() && node < o_ranges.back().end)
+    {
+      continue;
+    }
+    // parents come before children so each parent world matrix is final before it is used
+    unsigned int end = m_subtreeEnd[node];
+    for (unsigned int n = node; n < end; ++n)
+    {
+      unsigned int p = m_parent[n];
+      m_world[n] = p == s_noParent ? m_local[n] : m_world[p] * m_local[n];
+      m_dirty[n] = false;
+    }
+    // a subtree straight after the last one just extends it
+    if (!o_ranges.empty() && node == o_ranges.back().end)
+    {
+      o_ranges.back().end = end;
+    }
+    else
+    {
+      o_ranges.push_back({node, end});
+    }
+  }
+  m_dirtyNodes.clear();
+  return true;
+}
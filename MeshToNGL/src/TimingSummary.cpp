@@ -0,0 +1,25 @@
+#include "TimingSummary.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace TimingSummary
+{
+  Summary summarise(std::vector<double> _times)
+  {
+    Summary s;
+    if (_times.empty())
+    {
+      return s;
+    }
+    std::sort(_times.begin(), _times.end());
+    s.samples = _times.size();
+    s.total = std::accumulate(_times.begin(), _times.end(), 0.0);
+    s.mean = s.total / _times.size();
+    s.min = _times.front();
+    s.median = _times[_times.size() / 2];
+    size_t rank = static_cast<size_t>(std::ceil(0.99 * _times.size()));
+    s.p99 = _times[std::max<size_t>(rank, 1) - 1];
+    return s;
+  }
+}
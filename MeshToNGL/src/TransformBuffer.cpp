@@ -0,0 +1,117 @@
+#include "TransformBuffer.h"
+#include "RenderStats.h"
+#include <algorithm>
+#include <iostream>
+
+namespace
+{
+  ngl::Mat4 normalMatrix(const ngl::Mat4 &_world)
+  {
+    ngl::Mat4 n = _world;
+    n.inverse().transpose();
+    return n;
+  }
+} // end namespace
+
+TransformBuffer::TransformBuffer()
+{
+  glGenBuffers(1, &m_buffer);
+  glBindBuffer(GL_TEXTURE_BUFFER, m_buffer);
+  // allocate a single node so the texture is valid before the first upload
+  ngl::Mat4 identity[2] = {ngl::Mat4(1.0f), ngl::Mat4(1.0f)};
+  glBufferData(GL_TEXTURE_BUFFER, sizeof(identity), &identity[0].m_00, GL_STATIC_DRAW);
+  glGenTextures(1, &m_texture);
+  glBindTexture(GL_TEXTURE_BUFFER, m_texture);
+  glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, m_buffer);
+  glBindTexture(GL_TEXTURE_BUFFER, 0);
+  glBindBuffer(GL_TEXTURE_BUFFER, 0);
+  // the limit is in texels and each node takes 8, it only changes with the context so ask once
+  GLint maxTexels = 0;
+  glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+  m_maxNodes = static_cast<size_t>(maxTexels) / 8;
+}
+
+TransformBuffer::~TransformBuffer()
+{
+  glDeleteTextures(1, &m_texture);
+  glDeleteBuffers(1, &m_buffer);
+}
+
+void TransformBuffer::set(unsigned int _id, const ngl::Mat4 &_world)
+{
+  if (_id >= m_maxNodes)
+  {
+    if (!m_warned)
+    {
+      std::cerr << "TransformBuffer : node " << _id << " is past GL_MAX_TEXTURE_BUFFER_SIZE (" << m_maxNodes
+                << " nodes), it can't be drawn\n";
+      m_warned = true;
+    }
+    return;
+  }
+  if (_id >= size())
+  {
+    m_matrices.resize((_id + 1) * 2, ngl::Mat4(1.0f));
+  }
+  m_matrices[_id * 2] = _world;
+  m_matrices[_id * 2 + 1] = normalMatrix(_world);
+  // nodes are usually set in order so most calls just extend the last run
+  if (!m_dirty.empty() && m_dirty.back().second == _id)
+  {
+    ++m_dirty.back().second;
+  }
+  else
+  {
+    m_dirty.emplace_back(_id, _id + 1);
+  }
+}
+
+void TransformBuffer::upload()
+{
+  if (m_dirty.empty())
+  {
+    return;
+  }
+  glBindBuffer(GL_TEXTURE_BUFFER, m_buffer);
+  // the node count only changes when the scene is built so only reallocate when it grows
+  if (m_matrices.size() > m_capacity)
+  {
+    m_capacity = m_matrices.size();
+    auto bytes = static_cast<GLsizeiptr>(m_matrices.size() * sizeof(ngl::Mat4));
+    glBufferData(GL_TEXTURE_BUFFER, bytes, &m_matrices[0].m_00, GL_DYNAMIC_DRAW);
+    RenderStats::addBufferBytes(static_cast<size_t>(bytes));
+  }
+  else
+  {
+    std::sort(m_dirty.begin(), m_dirty.end());
+    for (size_t r = 0; r < m_dirty.size();)
+    {
+      // take in any following runs that overlap or are only a short gap away
+      size_t first = m_dirty[r].first;
+      size_t end = m_dirty[r].second;
+      for (++r; r < m_dirty.size() && m_dirty[r].first <= end + s_mergeGap; ++r)
+      {
+        end = std::max(end, m_dirty[r].second);
+      }
+      // each node is a world and normal matrix
+      auto offset = static_cast<GLintptr>(first * 2 * sizeof(ngl::Mat4));
+      auto bytes = static_cast<GLsizeiptr>((end - first) * 2 * sizeof(ngl::Mat4));
+      glBufferSubData(GL_TEXTURE_BUFFER, offset, bytes, &m_matrices[first * 2].m_00);
+      RenderStats::addBufferBytes(static_cast<size_t>(bytes));
+    }
+  }
+  glBindBuffer(GL_TEXTURE_BUFFER, 0);
+  m_dirty.clear();
+}
+
+void TransformBuffer::bind(GLuint _unit) const
+{
+  glActiveTexture(GL_TEXTURE0 + _unit);
+  glBindTexture(GL_TEXTURE_BUFFER, m_texture);
+}
+
+void TransformBuffer::setDrawID(unsigned int _id)
+{
+  // a constant attribute rather than a uniform, this is context state so survives VAO and program changes
+  glVertexAttribI1ui(s_drawIDAttribute, _id);
+}
@@ -0,0 +1,80 @@
+#include "UniformBinding.h"
+#include "RenderStats.h"
+#include <iostream>
+
+static_assert(sizeof(FrameUniforms::Block) == 4 * sizeof(ngl::Mat4) + 5 * sizeof(ngl::Vec4),
+              "FrameUniforms::Block must match the std140 layout of FrameBlock");
+
+UniformLocation::UniformLocation(GLuint _program, const char *_name)
+{
+  m_location = glGetUniformLocation(_program, _name);
+}
+
+void UniformLocation::set(int _value) const
+{
+  glUniform1i(m_location, _value);
+  RenderStats::addUniformUploads(1);
+}
+
+void UniformLocation::set(float _value) const
+{
+  glUniform1f(m_location, _value);
+  RenderStats::addUniformUploads(1);
+}
+
+void UniformLocation::set(const ngl::Vec3 &_value) const
+{
+  glUniform3f(m_location, _value.m_x, _value.m_y, _value.m_z);
+  RenderStats::addUniformUploads(1);
+}
+
+void UniformLocation::set(const ngl::Vec4 &_value) const
+{
+  glUniform4f(m_location, _value.m_x, _value.m_y, _value.m_z, _value.m_w);
+  RenderStats::addUniformUploads(1);
+}
+
+void UniformLocation::set(const ngl::Mat3 &_value) const
+{
+  glUniformMatrix3fv(m_location, 1, GL_FALSE, _value.m_openGL.data());
+  RenderStats::addUniformUploads(1);
+}
+
+void UniformLocation::set(const ngl::Mat4 &_value) const
+{
+  glUniformMatrix4fv(m_location, 1, GL_FALSE, _value.m_openGL.data());
+  RenderStats::addUniformUploads(1);
+}
+
+FrameUniforms::FrameUniforms()
+{
+  glGenBuffers(1, &m_buffer);
+  glBindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+  glBufferData(GL_UNIFORM_BUFFER, sizeof(Block), nullptr, GL_DYNAMIC_DRAW);
+  glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+FrameUniforms::~FrameUniforms()
+{
+  glDeleteBuffers(1, &m_buffer);
+}
+
+bool FrameUniforms::attach(GLuint _program) const
+{
+  GLuint index = glGetUniformBlockIndex(_program, "FrameBlock");
+  if (index == GL_INVALID_INDEX)
+  {
+    std::cerr << "program " << _program << " has no FrameBlock\n";
+    return false;
+  }
+  glUniformBlockBinding(_program, index, s_bindingPoint);
+  return true;
+}
+
+void FrameUniforms::upload()
+{
+  // binding to the indexed point also binds the generic one so the update needs no extra bind
+  glBindBufferBase(GL_UNIFORM_BUFFER, s_bindingPoint, m_buffer);
+  glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(Block), &m_data);
+  RenderStats::addBufferBytes(sizeof(Block));
+}
@@ -2,8 +2,15 @@
 basic OpenGL demo modified from http://qt-project.org/doc/qt-5.0/qtgui/openglwindow.html
 ****************************************************************************/
 #include <QtGui/QGuiApplication>
+#include <algorithm>
 #include <iostream>
+#include <string>
 #include "NGLScene.h"
+#include "AssetArchive.h"
+#include "HeadlessRenderer.h"
+#include "ImportProfile.h"
+#include "RenderStats.h"
+#include "ShaderCache.h"
 
 
 
@@ -30,12 +37,98 @@ int main(int argc, char **argv)
   // now set the depth buffer to 24 bits
   format.setDepthBufferSize(24);
   // now we are going to create our scene window
-  if(argc !=2 )
+  // usage MeshToNGL [--instances n] [--profile fast|balanced|max] [--import-timing] [--archive pack] [--no-shader-cache] [--stats frames] [--headless frames [--snapshot image]] file
+  std::string fname;
+  size_t instances=1;
+  size_t headlessFrames=0;
+  std::string snapshot;
+  // the post process preset, max unless changed with --profile
+  unsigned int importFlags=0;
+  ImportProfile::flagsForProfile("max",importFlags);
+  bool timeImport=false;
+  std::string archiveName;
+  // std::stoul throws on anything that isn't a number, report it with the usage rather than terminating
+  bool badNumber=false;
+  try
+  {
+    for(int i=1; i<argc; ++i)
+    {
+      std::string arg(argv[i]);
+      if(arg == "--instances" && i+1 < argc)
+      {
+        instances=std::max(1ul,std::stoul(argv[++i]));
+      }
+      else if(arg == "--profile" && i+1 < argc)
+      {
+        if(!ImportProfile::flagsForProfile(argv[++i],importFlags))
+        {
+          std::cout<<"unknown profile "<<argv[i]<<" use one of "<<ImportProfile::profileNames()<<"\n";
+          exit(EXIT_FAILURE);
+        }
+      }
+      else if(arg == "--import-timing")
+      {
+        timeImport=true;
+      }
+      else if(arg == "--archive" && i+1 < argc)
+      {
+        archiveName=argv[++i];
+      }
+      else if(arg == "--no-shader-cache")
+      {
+        ShaderCache::setEnabled(false);
+      }
+      else if(arg == "--stats" && i+1 < argc)
+      {
+        RenderStats::setReportInterval(std::stoul(argv[++i]));
+      }
+      else if(arg == "--headless" && i+1 < argc)
+      {
+        headlessFrames=std::max(1ul,std::stoul(argv[++i]));
+      }
+      else if(arg == "--snapshot" && i+1 < argc)
+      {
+        snapshot=argv[++i];
+      }
+      else
+      {
+        fname=arg;
+      }
+    }
+  }
+  catch(const std::exception &)
+  {
+    badNumber=true;
+  }
+  if(fname.empty() || badNumber)
    {
-     std::cout<<"need to pass name of file to load\n";
+     std::cout<<(badNumber ? "expected a number after an option\n" : "need to pass name of file to load\n");
+     std::cout<<"usage MeshToNGL [--instances n] [--profile fast|balanced|max] [--import-timing] [--archive pack] [--no-shader-cache] [--stats frames] [--headless frames [--snapshot image]] file\n";
      exit(EXIT_FAILURE);
    }
-  NGLScene window(argv[1]);
+  // with --archive the file name is a path inside the archive
+  std::shared_ptr<AssetArchive> archive;
+  if(!archiveName.empty())
+  {
+    archive=AssetArchive::open(archiveName);
+    if(!archive)
+    {
+      exit(EXIT_FAILURE);
+    }
+  }
+  if(headlessFrames > 0)
+  {
+    // no window, draw a fixed number of frames into an FBO and report the times. The renderer
+    // owns the context so must outlive the scene
+    HeadlessRenderer renderer(format,1024,720);
+    if(!renderer.isValid())
+    {
+      exit(EXIT_FAILURE);
+    }
+    NGLScene scene(fname,instances,importFlags,timeImport,archive);
+    return renderer.run(scene,headlessFrames,snapshot);
+  }
+  NGLScene window(fname,instances,importFlags,timeImport,archive);
   // and set the OpenGL format
   window.setFormat(format);
   // we can now query the version to see if it worked
@@ -15,18 +15,53 @@ isEqual(QT_MAJOR_VERSION, 5) {
 MOC_DIR=moc
 # on a mac we don't create a .app bundle file ( for ease of multiplatform use)
 CONFIG-=app_bundle
+# the frame profiler, remove this to compile it out
+DEFINES+=PROFILER_ENABLED
 # Auto include all .cpp files in the project src directory (can specifiy individually if required)
 SOURCES+= $$PWD/src/AIUtil.cpp   \
 					$$PWD/src/Mesh.cpp      \
+          $$PWD/src/MeshRender.cpp \
 					$$PWD/src/NGLScene.cpp \
           $$PWD/src/NGLSceneMouseControls.cpp \
           $$PWD/src/MultiBufferIndexVAO.cpp \
+          $$PWD/src/Simplify.cpp \
+          $$PWD/src/Profiler.cpp \
+          $$PWD/src/ImportProfile.cpp \
+          $$PWD/src/MappedIOSystem.cpp \
+          $$PWD/src/AssetArchive.cpp \
+          $$PWD/src/ArchiveIOSystem.cpp \
+          $$PWD/src/ShaderCache.cpp \
+          $$PWD/src/UniformBinding.cpp \
+          $$PWD/src/LinearArena.cpp \
+          $$PWD/src/FrameScheduler.cpp \
+          $$PWD/src/PosePipeline.cpp \
+          $$PWD/src/AssetManager.cpp \
+          $$PWD/src/RenderStats.cpp \
+          $$PWD/src/HeadlessRenderer.cpp \
+          $$PWD/src/TimingSummary.cpp \
+          $$PWD/src/BonePaletteBuffer.cpp \
           $$PWD/src/main.cpp
 # same for the .h files
 HEADERS+= $$PWD/include/AIUtil.h  \
 					$$PWD/include/Mesh.h    \
           $$PWD/include/NGLScene.h \
           $$PWD/include/MultiBufferIndexVAO.h  \
+          $$PWD/include/Simplify.h  \
+          $$PWD/include/HeadlessRenderer.h \
+          $$PWD/include/TimingSummary.h \
+          $$PWD/include/RenderStats.h \
+          $$PWD/include/ImportProfile.h \
+          $$PWD/include/MappedIOSystem.h \
+          $$PWD/include/AssetArchive.h \
+          $$PWD/include/ArchiveIOSystem.h \
+          $$PWD/include/ShaderCache.h \
+          $$PWD/include/UniformBinding.h \
+          $$PWD/include/LinearArena.h \
+          $$PWD/include/FrameScheduler.h \
+          $$PWD/include/PosePipeline.h \
+          $$PWD/include/AssetManager.h \
+          $$PWD/include/Profiler.h  \
+          $$PWD/include/BonePaletteBuffer.h  \
           $$PWD/include/WindowParams.h
 # and add the include dir into the search path for Qt and make
 INCLUDEPATH +=./include
@@ -36,7 +71,7 @@ DESTDIR=./
 OTHER_FILES+= shaders/*.glsl \
 							README.md
 
-!win32:LIBS+=-lassimp
+!win32:LIBS+=-lassimp -lpthread
 win32:{
     message(Make sure that assimp is installed using vcpkg install assimp )
   #  message("package dir is" $$VCPK)
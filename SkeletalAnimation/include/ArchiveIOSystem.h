@@ -0,0 +1,31 @@
+#ifndef ARCHIVEIOSYSTEM_H_
+#define ARCHIVEIOSYSTEM_H_
+#include <assimp/IOSystem.hpp>
+#include <memory>
+#include "AssetArchive.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @class ArchiveIOSystem
+/// @brief an assimp IO system which reads from an AssetArchive, so a model and any files it pulls in
+/// (md5anim, materials etc.) come from the one mapping with no further opens. Streams point straight
+/// into the mapping, nothing is copied. Paths are relative to the root of the archive.
+/// Give it to the importer with Importer::SetIOHandler(new ArchiveIOSystem(archive)) the importer then owns it.
+//----------------------------------------------------------------------------------------------------------------------
+class ArchiveIOSystem : public Assimp::IOSystem
+{
+  public :
+    explicit ArchiveIOSystem(std::shared_ptr<AssetArchive> _archive);
+    bool Exists(const char *_file) const override;
+    char getOsSeparator() const override;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief open a file from the archive, the archive is read only so any write mode fails
+    /// @returns the stream or nullptr if the file is not in the archive
+    //----------------------------------------------------------------------------------------------------------------------
+    Assimp::IOStream *Open(const char *_file, const char *_mode="rb") override;
+    void Close(Assimp::IOStream *_file) override;
+
+  private :
+    std::shared_ptr<AssetArchive> m_archive;
+};
+
+#endif
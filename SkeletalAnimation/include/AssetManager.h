@@ -0,0 +1,89 @@
+#ifndef ASSETMANAGER_H_
+#define ASSETMANAGER_H_
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include "AssetArchive.h"
+#include "Mesh.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @class AssetManager
+/// @brief loads each model once and hands out shared handles to it. Models are keyed by path, a hash of
+/// the file contents and the import flags, so asking for the same file again (however many times) returns
+/// the same Mesh, skeleton, clips and GPU buffers rather than a new copy, while a file that has changed on
+/// disk or is loaded with different flags gets its own entry. The manager only keeps weak references so
+/// a model is freed as soon as the last handle goes. Anything per character (time, clip, transform) belongs
+/// to the caller, not the Mesh.
+//----------------------------------------------------------------------------------------------------------------------
+class AssetManager
+{
+  public :
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief ctor
+    /// @param[in] _archive if set models are read from this archive, otherwise from disk through MappedIOSystem
+    //----------------------------------------------------------------------------------------------------------------------
+    explicit AssetManager(std::shared_ptr<AssetArchive> _archive=nullptr);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief get a handle to a model, loading it if it is not already loaded. A new load creates the
+    /// VAO so needs a current GL context
+    /// @param[in] _fname the file to load
+    /// @param[in] _flags the assimp post process flags (see ImportProfile)
+    /// @param[in] _timeSteps print the time taken by each import step, the LODs and the load scratch (only for a
+    /// new load)
+    /// @returns the mesh or nullptr if it can't be loaded
+    //----------------------------------------------------------------------------------------------------------------------
+    std::shared_ptr<Mesh> load(const std::string &_fname, unsigned int _flags, bool _timeSteps=false);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief how many models are currently held by at least one handle
+    //----------------------------------------------------------------------------------------------------------------------
+    size_t liveAssets() const;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief how many calls to load were served from the cache and how many had to import the file
+    //----------------------------------------------------------------------------------------------------------------------
+    size_t hits() const { return m_hits; }
+    size_t misses() const { return m_misses; }
+
+  private :
+    struct Key
+    {
+      std::string path;
+      uint64_t hash;
+      unsigned int flags;
+      bool operator==(const Key &_k) const { return hash == _k.hash && flags == _k.flags && path == _k.path; }
+    };
+    struct KeyHash
+    {
+      size_t operator()(const Key &_k) const;
+    };
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the importer owns the aiScene the Mesh animates from so they live and die together
+    //----------------------------------------------------------------------------------------------------------------------
+    struct Asset
+    {
+      Assimp::Importer importer;
+      Mesh mesh;
+    };
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief hash the file contents, archive entries already have a hash in the index and loose files
+    /// are only re-hashed if their size or modification time changes
+    /// @returns false if the file can't be read
+    //----------------------------------------------------------------------------------------------------------------------
+    bool contentHash(const std::string &_fname, uint64_t &o_hash);
+    struct FileStamp
+    {
+      uintmax_t size;
+      std::filesystem::file_time_type time;
+      uint64_t hash;
+    };
+
+    std::shared_ptr<AssetArchive> m_archive;
+    std::unordered_map<Key, std::weak_ptr<Asset>, KeyHash> m_assets;
+    std::unordered_map<std::string, FileStamp> m_stamps;
+    size_t m_hits=0;
+    size_t m_misses=0;
+};
+
+#endif
@@ -0,0 +1,72 @@
+#ifndef BONEPALETTEBUFFER_H_
+#define BONEPALETTEBUFFER_H_
+
+#include <ngl/Types.h>
+#include <ngl/Mat4.h>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @class BonePaletteBuffer
+/// @brief holds the bone palettes for every instance of a skinned mesh in a texture buffer so a whole
+/// crowd can be drawn with one instanced draw. Each matrix is stored as 4 RGBA32F texels (one per column)
+/// and the shader finds bone b of instance i at texel (i * numBones + b) * 4
+//----------------------------------------------------------------------------------------------------------------------
+class BonePaletteBuffer
+{
+  public :
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief ctor creates the buffer and texture so we must have a valid GL context
+    //----------------------------------------------------------------------------------------------------------------------
+    BonePaletteBuffer();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief dtor releases the GL resources
+    //----------------------------------------------------------------------------------------------------------------------
+    ~BonePaletteBuffer();
+    BonePaletteBuffer(const BonePaletteBuffer &)=delete;
+    BonePaletteBuffer &operator=(const BonePaletteBuffer &)=delete;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief upload all the palettes packed one instance after another, the buffer is orphaned
+    /// each time so we don't stall on the previous frame still using it
+    /// @param[in] _palettes the matrices in the same layout as the old gBones uniform upload
+    /// @note palettes past capacity() are dropped with a warning, callers should limit the
+    /// number of instances they draw to capacity() / numBones
+    //----------------------------------------------------------------------------------------------------------------------
+    void upload(const std::vector<ngl::Mat4> &_palettes);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief bind the texture buffer ready for drawing
+    /// @param[in] _unit the texture unit to use, the samplerBuffer uniform should be set to this
+    //----------------------------------------------------------------------------------------------------------------------
+    void bind(GLuint _unit=0) const;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the number of matrices in the last upload
+    //----------------------------------------------------------------------------------------------------------------------
+    size_t size() const { return m_size; }
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the most matrices the texture buffer can address, from GL_MAX_TEXTURE_BUFFER_SIZE
+    //----------------------------------------------------------------------------------------------------------------------
+    size_t capacity() const { return m_capacity; }
+
+  private :
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the buffer storing the matrices
+    //----------------------------------------------------------------------------------------------------------------------
+    GLuint m_buffer=0;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the texture used to view the buffer from the shader
+    //----------------------------------------------------------------------------------------------------------------------
+    GLuint m_texture=0;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief number of matrices in the last upload
+    //----------------------------------------------------------------------------------------------------------------------
+    size_t m_size=0;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief matrices the texture buffer can hold, queried once in the ctor
+    //----------------------------------------------------------------------------------------------------------------------
+    size_t m_capacity=0;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief set once we have warned about going over the limit so we don't spam every frame
+    //----------------------------------------------------------------------------------------------------------------------
+    bool m_warned=false;
+};
+
+#endif
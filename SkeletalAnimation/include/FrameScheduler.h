@@ -0,0 +1,97 @@
+#ifndef FRAMESCHEDULER_H_
+#define FRAMESCHEDULER_H_
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @class FrameScheduler
+/// @brief paces the animation from a monotonic clock. Frames are driven by the buffer swap (so they run
+/// at the display rate) only while animating, the animation clock moves in fixed steps so playback is the
+/// same whatever the frame rate and a pose only changes when a step has passed. The interval between
+/// animated frames is kept so the jitter can be reported.
+//----------------------------------------------------------------------------------------------------------------------
+class FrameScheduler
+{
+  public :
+    using Clock=std::chrono::steady_clock;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief summary of the frame intervals in milliseconds
+    //----------------------------------------------------------------------------------------------------------------------
+    struct Stats
+    {
+      size_t frames=0;
+      double mean=0.0;
+      /// @brief the standard deviation of the interval
+      double jitter=0.0;
+      double min=0.0;
+      double max=0.0;
+    };
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief number of frame intervals kept for the stats
+    //----------------------------------------------------------------------------------------------------------------------
+    static constexpr size_t s_window=300;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief ctor
+    /// @param[in] _step the fixed animation step in seconds
+    //----------------------------------------------------------------------------------------------------------------------
+    explicit FrameScheduler(double _step=1.0/60.0);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief start or stop the animation clock, while stopped the time holds and wantsFrame is false
+    /// so the window only redraws for input
+    //----------------------------------------------------------------------------------------------------------------------
+    void setAnimating(bool _animating);
+    bool animating() const { return m_animating; }
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief call at the start of each frame, this measures the time since the last frame and moves the
+    /// animation clock on by as many whole steps as fit
+    //----------------------------------------------------------------------------------------------------------------------
+    void beginFrame();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief true if another frame should be requested once this one has been swapped
+    //----------------------------------------------------------------------------------------------------------------------
+    bool wantsFrame() const { return m_animating; }
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the animation time in seconds, always a whole number of steps
+    //----------------------------------------------------------------------------------------------------------------------
+    double time() const { return m_time; }
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the number of steps taken by the last beginFrame, 0 means the pose is the same as last frame
+    //----------------------------------------------------------------------------------------------------------------------
+    unsigned int steps() const { return m_steps; }
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief how far into the next step we are (0-1), for interpolating between steps
+    //----------------------------------------------------------------------------------------------------------------------
+    double alpha() const { return m_accumulator / m_step; }
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the intervals between the last s_window animated frames
+    //----------------------------------------------------------------------------------------------------------------------
+    Stats stats() const;
+
+  private :
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the longest time a frame can move the animation on by, after a stall (or a debugger break)
+    /// the animation skips ahead this much rather than running every missed step
+    //----------------------------------------------------------------------------------------------------------------------
+    static constexpr double s_maxFrameTime=0.25;
+    double m_step;
+    double m_time=0.0;
+    double m_accumulator=0.0;
+    unsigned int m_steps=0;
+    bool m_animating=false;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief set when the last frame was an animated one so the interval to this frame is meaningful
+    //----------------------------------------------------------------------------------------------------------------------
+    bool m_continuous=false;
+    Clock::time_point m_lastFrame;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief ring buffer of frame intervals in milliseconds
+    //----------------------------------------------------------------------------------------------------------------------
+    std::array<double,s_window> m_intervals;
+    size_t m_numIntervals=0;
+    size_t m_nextInterval=0;
+};
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef HEADLESSRENDERER_H_
+#define HEADLESSRENDERER_H_
+
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+#include <QOpenGLFramebufferObject>
+#include <QSurfaceFormat>
+#include <memory>
+#include <string>
+
+class NGLScene;
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @class HeadlessRenderer
+/// @brief drives an NGLScene without a window, the scene is drawn into an FBO attached to a
+/// QOffscreenSurface so this works with QT_QPA_PLATFORM=offscreen and a software GL such as Mesa's
+/// llvmpipe. Each frame is set up with NGLScene::setFixedFrame so runs are repeatable and can be
+/// image diffed. The renderer must be created before the scene (and so destroyed after it) as the
+/// scene releases its GL resources in its dtor.
+//----------------------------------------------------------------------------------------------------------------------
+class HeadlessRenderer
+{
+  public :
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief create the context, surface and FBO and make the context current
+    /// @param[in] _format the GL format to request
+    /// @param[in] _width the width of the FBO
+    /// @param[in] _height the height of the FBO
+    //----------------------------------------------------------------------------------------------------------------------
+    HeadlessRenderer(const QSurfaceFormat &_format, int _width, int _height);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief true if we have a usable context and FBO
+    //----------------------------------------------------------------------------------------------------------------------
+    bool isValid() const { return m_valid; }
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief initialise the scene, draw _frames frames and print the frame times
+    /// @param[in] _scene the scene to draw, initializeGL is called from here
+    /// @param[in] _frames how many frames to draw
+    /// @param[in] _snapshot if not empty the last frame is saved to this image file
+    /// @returns EXIT_SUCCESS or EXIT_FAILURE
+    //----------------------------------------------------------------------------------------------------------------------
+    int run(NGLScene &_scene, size_t _frames, const std::string &_snapshot);
+
+  private :
+    QOpenGLContext m_context;
+    QOffscreenSurface m_surface;
+    std::unique_ptr<QOpenGLFramebufferObject> m_fbo;
+    int m_width;
+    int m_height;
+    bool m_valid=false;
+};
+
+#endif
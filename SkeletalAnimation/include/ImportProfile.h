@@ -0,0 +1,39 @@
+#ifndef IMPORTPROFILE_H_
+#define IMPORTPROFILE_H_
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+#include <string>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief named sets of assimp post process flags so the load time / mesh quality trade off can be chosen
+/// per asset from the command line, and a loader that can report how long each step takes
+//----------------------------------------------------------------------------------------------------------------------
+namespace ImportProfile
+{
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief look up the flags for a profile
+  /// fast is aiProcessPreset_TargetRealtime_Fast, balanced is aiProcessPreset_TargetRealtime_Quality and max is
+  /// aiProcessPreset_TargetRealtime_MaxQuality, all of them also triangulate
+  /// @param[in] _name the profile name
+  /// @param[out] o_flags the post process flags
+  /// @returns false if the name is unknown
+  //----------------------------------------------------------------------------------------------------------------------
+  extern bool flagsForProfile(const std::string &_name, unsigned int &o_flags);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the valid profile names for usage messages
+  //----------------------------------------------------------------------------------------------------------------------
+  extern const char *profileNames();
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief load a file with the importer. If _timeSteps is set the file is read with no post processing
+  /// and then each step is applied on its own (in the order assimp runs them) so the time of the read and
+  /// of every step can be printed, otherwise this is just ReadFile
+  /// @param[in] _importer the importer which will own the scene
+  /// @param[in] _fname the file to load
+  /// @param[in] _flags the post process flags
+  /// @param[in] _timeSteps print per step timing
+  /// @returns the scene or nullptr on failure (see _importer.GetErrorString())
+  //----------------------------------------------------------------------------------------------------------------------
+  extern const aiScene *readFile(Assimp::Importer &_importer, const std::string &_fname, unsigned int _flags, bool _timeSteps);
+}
+
+#endif
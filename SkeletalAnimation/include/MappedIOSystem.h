@@ -0,0 +1,59 @@
+#ifndef MAPPEDIOSYSTEM_H_
+#define MAPPEDIOSYSTEM_H_
+#include <assimp/DefaultIOSystem.h>
+#include <assimp/IOStream.hpp>
+#include <cstddef>
+#include <cstdint>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @class MappedIOStream
+/// @brief a read only assimp stream over a memory mapped file, reads are a memcpy from the mapped pages so
+/// there is no stdio buffer in between and the kernel can drop / re-read the pages as needed
+//----------------------------------------------------------------------------------------------------------------------
+class MappedIOStream : public Assimp::IOStream
+{
+  public :
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the stream takes ownership of the mapping and unmaps it in the dtor
+    /// @param[in] _data the start of the mapping (may be nullptr for an empty file)
+    /// @param[in] _size the size of the file in bytes
+    //----------------------------------------------------------------------------------------------------------------------
+    MappedIOStream(const uint8_t *_data, size_t _size);
+    ~MappedIOStream() override;
+    MappedIOStream(const MappedIOStream &)=delete;
+    MappedIOStream &operator=(const MappedIOStream &)=delete;
+    size_t Read(void *o_buffer, size_t _size, size_t _count) override;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the stream is read only so this always fails
+    //----------------------------------------------------------------------------------------------------------------------
+    size_t Write(const void *_buffer, size_t _size, size_t _count) override;
+    aiReturn Seek(size_t _offset, aiOrigin _origin) override;
+    size_t Tell() const override;
+    size_t FileSize() const override;
+    void Flush() override;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief direct access to the mapped file
+    //----------------------------------------------------------------------------------------------------------------------
+    const uint8_t *data() const { return m_data; }
+
+  private :
+    const uint8_t *m_data;
+    size_t m_size;
+    size_t m_pos=0;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @class MappedIOSystem
+/// @brief an assimp IO system which memory maps files opened for reading (with MADV_SEQUENTIAL as the
+/// parsers mostly read front to back). Anything opened for writing, or any file on a platform without
+/// mmap, goes through the default stdio implementation. Give it to the importer with
+/// Importer::SetIOHandler(new MappedIOSystem) the importer then owns it.
+//----------------------------------------------------------------------------------------------------------------------
+class MappedIOSystem : public Assimp::DefaultIOSystem
+{
+  public :
+    using Assimp::DefaultIOSystem::Open;
+    Assimp::IOStream *Open(const char *_file, const char *_mode="rb") override;
+};
+
+#endif
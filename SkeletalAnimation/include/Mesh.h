@@ -17,6 +17,8 @@
 #include <assimp/cimport.h>
 #include <array>
 #include <memory>
+#include "Simplify.h"
+#include "LinearArena.h"
 
 constexpr int s_bonesPerVertex=4;
 
@@ -37,13 +39,59 @@ public :
   /// @brief loads the animation / mesh data from a aiScene. It is important that this scene is
   /// static and not destroyed by the client
   /// @param[in] _scene a pre-loaded scene
+  /// @param[in] _verbose print the LODs of each entry and the conversion scratch used
   //----------------------------------------------------------------------------------------------------------------------
 
-  bool load(const aiScene *_scene);
+  bool load(const aiScene *_scene, bool _verbose=false);
   //----------------------------------------------------------------------------------------------------------------------
-  /// @brief draw the mesh at the current time
+  /// @brief Vertex bone data
+  //----------------------------------------------------------------------------------------------------------------------
+  struct VertexBoneData
+  {
+      std::array<unsigned int,s_bonesPerVertex> ids;
+      std::array<float,s_bonesPerVertex> weights;
+      void addBoneData(unsigned int BoneID, float Weight);
+  };
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the converted vertex streams ready to upload, all the meshes in the scene are packed
+  /// one after another using the MeshEntry base vertex / index. The streams and the conversion scratch
+  /// are allocated from the arena so are all freed at once when this goes out of scope.
+  /// With vertexStreams false the positions, normals and uvs are left empty, createVAO then writes
+  /// them straight from the aiMesh arrays into the GPU buffers so they are never copied on the CPU
+  //----------------------------------------------------------------------------------------------------------------------
+  struct GeometryData
+  {
+      bool vertexStreams=true;
+      unsigned int numVertices=0;
+      LinearArena arena;
+      ArenaVector<ngl::Vec3> positions{arena};
+      ArenaVector<ngl::Vec3> normals{arena};
+      ArenaVector<ngl::Vec2> texCoords{arena};
+      ArenaVector<VertexBoneData> bones{arena};
+      ArenaVector<unsigned int> indices{arena};
+  };
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the CPU side of load, this converts the geometry, bones and LODs but doesn't touch GL
+  /// so can be used without a context (for example in the benchmarks)
+  /// @param[in] _scene a pre-loaded scene
+  /// @param[out] o_data the converted vertex streams
+  //----------------------------------------------------------------------------------------------------------------------
+  bool loadData(const aiScene *_scene, GeometryData &o_data);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief draw a range of instances at one LOD, one instanced draw per mesh entry
+  /// @param[in] _lod the level from Simplify::selectLOD with Simplify::s_maxLODs levels, entries with
+  /// fewer levels use their last one. 0 will always draw the full mesh
+  /// @param[in] _firstInstance the first instance to draw, its model matrix is read from this point of
+  /// setInstanceTransforms. The shader's instanceBase must be set to the same value to find the palettes
+  /// @param[in] _numInstances how many instances to draw, each one reads its own bone palette
+  /// from the palette buffer and its model matrix from setInstanceTransforms
+  //----------------------------------------------------------------------------------------------------------------------
+  void render(size_t _lod=0, size_t _firstInstance=0, size_t _numInstances=1) const;
   //----------------------------------------------------------------------------------------------------------------------
-  void render() const;
+  /// @brief set the per instance model matrices used by render
+  /// @param[in] _transforms one matrix per instance
+  //----------------------------------------------------------------------------------------------------------------------
+  void setInstanceTransforms(const std::vector<ngl::Mat4> &_transforms);
   //----------------------------------------------------------------------------------------------------------------------
   /// @brief accessor for the number of bones in the mesh
   //----------------------------------------------------------------------------------------------------------------------
@@ -58,15 +106,55 @@ public :
   double getTicksPerSec() const { return m_scene->mAnimations[0]->mTicksPerSecond;}
   //----------------------------------------------------------------------------------------------------------------------
   /// @brief this set the bone transformation for the current time. This is then passed to the shader
-  /// to do the animation of the mesh
+  /// to do the animation of the mesh. The last palette is kept so asking for the same clip and time again
+  /// (a paused or idle scene) is just a copy rather than walking the hierarchy
   /// @param[in] _timeInSeconds the time to set the animation frame to
   /// @param[out] _transforms an array of transform matrices for the current frame
+  /// @returns true if the palette was evaluated, false if it is the cached one from the last call
+  //----------------------------------------------------------------------------------------------------------------------
+  bool boneTransform(float _timeInSeconds, std::vector<ngl::Mat4>& o_transforms);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief as above but for a given clip rather than the active one, so characters sharing a Mesh
+  /// can each play their own clip
+  /// @param[in] _animation the clip index, must be less than numAnimations()
+  //----------------------------------------------------------------------------------------------------------------------
+  bool boneTransform(float _timeInSeconds, std::vector<ngl::Mat4>& o_transforms, unsigned int _animation);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief evaluate the palette for a clip and time without the cache. This only reads the mesh so any
+  /// number of threads can evaluate poses from the same Mesh at once (see PosePipeline)
+  /// @param[in] _timeInSeconds the time to set the animation frame to
+  /// @param[in] _animation the clip index, must be less than numAnimations()
+  /// @param[out] o_transforms the palette, resized to numBones()
+  //----------------------------------------------------------------------------------------------------------------------
+  void evaluatePose(float _timeInSeconds, unsigned int _animation, std::vector<ngl::Mat4>& o_transforms) const;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief how many clips are in the scene
   //----------------------------------------------------------------------------------------------------------------------
-  void boneTransform(float _timeInSeconds, std::vector<ngl::Mat4>& o_transforms);
+  unsigned int numAnimations() const { return m_numAnimations; }
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief get the bounds of the skinned mesh for a given bone palette. Each bone has a bind pose box
+  /// built at load time from the vertices it influences, these are moved by the palette so the cost is
+  /// O(bones) rather than O(vertices)
+  /// @param[in] _transforms the palette as returned from boneTransform
+  /// @param[out] o_min the min extent of the box
+  /// @param[out] o_max the max extent of the box
+  //----------------------------------------------------------------------------------------------------------------------
+  void getAnimatedBounds(const std::vector<ngl::Mat4> &_transforms, ngl::Vec3 &o_min, ngl::Vec3 &o_max) const;
 
   void setActiveAnimation(int _anim);
-
-private :
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief calculate the scale value between two keys, these only depend on the channel passed in
+  /// so are static and public to allow them to be benchmarked on their own
+  //----------------------------------------------------------------------------------------------------------------------
+  static ngl::Vec3 calcInterpolatedScaling(float _animationTime, const aiNodeAnim* _nodeAnim);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief calculate the rotation value between two keys
+  //---------------------------------------------------------------------------------------------------------------------
+  static ngl::Quaternion calcInterpolatedRotation(float _animationTime, const aiNodeAnim* _nodeAnim);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief calculate the position value between two keys
+  //----------------------------------------------------------------------------------------------------------------------
+  static ngl::Vec3 calcInterpolatedPosition(float _animationTime, const aiNodeAnim* _nodeAnim);
 
   //----------------------------------------------------------------------------------------------------------------------
   /// @brief the bone information structure to store the data
@@ -74,18 +162,11 @@ private :
   struct BoneInfo
   {
     ngl::Mat4 boneOffset;
-    ngl::Mat4 finalTransformation;
+    /// @brief bind pose box of the vertices influenced by this bone
+    ngl::Vec3 boundsMin=ngl::Vec3(1e10f,1e10f,1e10f);
+    ngl::Vec3 boundsMax=ngl::Vec3(-1e10f,-1e10f,-1e10f);
+    bool hasBounds=false;
   };
-  //----------------------------------------------------------------------------------------------------------------------
-  /// @brief Vertex bone data
-  //----------------------------------------------------------------------------------------------------------------------
-  struct VertexBoneData
-  {
-      std::array<unsigned int,s_bonesPerVertex> ids;
-      std::array<float,s_bonesPerVertex> weights;
-      void addBoneData(unsigned int BoneID, float Weight);
-  };
-
   //----------------------------------------------------------------------------------------------------------------------
   /// @brief Mesh data
   //----------------------------------------------------------------------------------------------------------------------
@@ -96,59 +177,87 @@ private :
           NumIndices    = 0;
           BaseVertex    = 0;
           BaseIndex     = 0;
+          NumLODs       = 1;
+          IndexSize     = sizeof(unsigned int);
       }
 
       unsigned int NumIndices;
       unsigned int BaseVertex;
       unsigned int BaseIndex;
+      /// @brief the index range for each LOD, these all share the same vertices and index buffer
+      /// level 0 is the same as NumIndices / BaseIndex
+      unsigned int NumLODs;
+      std::array<unsigned int,Simplify::s_maxLODs> LODNumIndices;
+      std::array<unsigned int,Simplify::s_maxLODs> LODBaseIndex;
+      /// @brief bytes per index on the GPU, the indices are relative to BaseVertex so an entry with
+      /// no more than 65536 vertices uploads them as 16 bit
+      unsigned int IndexSize;
+      /// @brief byte offset of each LOD in the uploaded index buffer, set by createVAO
+      std::array<size_t,Simplify::s_maxLODs> LODIndexOffset;
   };
 
   //----------------------------------------------------------------------------------------------------------------------
-  /// @brief calculate the scale value between two keys
-  //----------------------------------------------------------------------------------------------------------------------
-  ngl::Vec3 calcInterpolatedScaling(float _animationTime, const aiNodeAnim* _nodeAnim);
+  /// @brief read only access to the converted data, used by the tools that cook assets offline
   //----------------------------------------------------------------------------------------------------------------------
-  /// @brief calculate the rotation value between two keys
-  //---------------------------------------------------------------------------------------------------------------------
-  ngl::Quaternion calcInterpolatedRotation(float _animationTime, const aiNodeAnim* _nodeAnim);
+  const std::vector<MeshEntry> &entries() const { return m_entries; }
+  const std::vector<BoneInfo> &boneInfo() const { return m_boneInfo; }
+  const std::map<std::string,unsigned int> &boneMapping() const { return m_boneMapping; }
+
+private :
+
   //----------------------------------------------------------------------------------------------------------------------
-  /// @brief calculate the position value between two keys
+  /// @brief find the current node animation
   //----------------------------------------------------------------------------------------------------------------------
-  ngl::Vec3 calcInterpolatedPosition(float _animationTime, const aiNodeAnim* _nodeAnim);
+  const aiNodeAnim* findNodeAnim(const aiAnimation* _animation, const std::string &_nodeName) const;
   //----------------------------------------------------------------------------------------------------------------------
-  /// @brief find the current node animation
+  /// @brief the time in ticks into a clip, wrapped to the clip duration
   //----------------------------------------------------------------------------------------------------------------------
-  const aiNodeAnim* findNodeAnim(const aiAnimation* _animation, const std::string &_nodeName);
+  float animationTime(float _timeInSeconds, unsigned int _animation) const;
   //----------------------------------------------------------------------------------------------------------------------
-  /// @brief recurse the node for the next animation node
+  /// @brief recurse the node for the next animation node, writing the final transform of each bone
+  /// into o_transforms
   //----------------------------------------------------------------------------------------------------------------------
-  void recurseNodeHeirarchy(float _animationTime, const aiNode* _node, const ngl::Mat4& _parentTransform);
+  void recurseNodeHeirarchy(float _animationTime, const aiAnimation* _animation, const aiNode* _node,
+                            const ngl::Mat4& _parentTransform, std::vector<ngl::Mat4> &o_transforms) const;
   //----------------------------------------------------------------------------------------------------------------------
   /// @brief  init our data structures from the scene
   //----------------------------------------------------------------------------------------------------------------------
-  void initFromScene(const aiScene* _scene);
+  void initFromScene(const aiScene* _scene, GeometryData &o_data);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief  upload the converted data to our VAO, this is the only part of loading that needs GL.
+  /// The positions, normals and uvs are written from the aiMesh arrays of m_scene into the buffers
+  /// and the indices of each entry are packed at its IndexSize
+  //----------------------------------------------------------------------------------------------------------------------
+  void createVAO(GeometryData &io_data);
   //----------------------------------------------------------------------------------------------------------------------
   /// @brief  create our mesh
   //----------------------------------------------------------------------------------------------------------------------
   void initMesh(
                 unsigned int _meshIndex,
                 const aiMesh* _aiMesh,
-                std::vector<ngl::Vec3>& o_positions,
-                std::vector<ngl::Vec3>& o_normals,
-                std::vector<ngl::Vec2>& o_texCoords,
-                std::vector<VertexBoneData>& o_bones,
-                std::vector<unsigned int>& o_indices
+                ArenaVector<ngl::Vec3>& o_positions,
+                ArenaVector<ngl::Vec3>& o_normals,
+                ArenaVector<ngl::Vec2>& o_texCoords,
+                ArenaVector<VertexBoneData>& o_bones,
+                ArenaVector<unsigned int>& o_indices,
+                bool _vertexStreams
                 );
   //----------------------------------------------------------------------------------------------------------------------
   /// @brief  load the bone data
   //----------------------------------------------------------------------------------------------------------------------
 
-  void loadBones(unsigned int _meshIndex, const aiMesh* _mesh, std::vector<VertexBoneData>& o_bones);
+  void loadBones(unsigned int _meshIndex, const aiMesh* _mesh, ArenaVector<VertexBoneData>& o_bones);
   //----------------------------------------------------------------------------------------------------------------------
   /// @brief clear all the allocated data
   //----------------------------------------------------------------------------------------------------------------------
 
   void clear();
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief delete the VAO and instance buffer, this lives in MeshRender.cpp with the rest of the GL code
+  /// and clear() only reaches it through m_releaseGL so Mesh.cpp links without GL
+  /// @param[in] io_mesh the mesh whose GL objects are released
+  //----------------------------------------------------------------------------------------------------------------------
+  static void releaseGL(Mesh &io_mesh);
 
 
   //----------------------------------------------------------------------------------------------------------------------
@@ -181,6 +290,14 @@ private :
   //----------------------------------------------------------------------------------------------------------------------
   ngl::Mat4 m_globalInverseTransform;
   //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the clip and time in ticks of the last palette boneTransform evaluated, the clip is
+  /// s_noPose until the first call
+  //----------------------------------------------------------------------------------------------------------------------
+  static constexpr unsigned int s_noPose=~0u;
+  unsigned int m_poseAnimation=s_noPose;
+  float m_poseTime=0.0f;
+  std::vector<ngl::Mat4> m_posePalette;
+  //----------------------------------------------------------------------------------------------------------------------
   /// @brief pointer to the mesh scene
   //----------------------------------------------------------------------------------------------------------------------
   const aiScene* m_scene;
@@ -188,6 +305,14 @@ private :
   /// @brief the vertex array object to store the mesh data
   //----------------------------------------------------------------------------------------------------------------------
   std::unique_ptr<ngl::AbstractVAO>m_vao;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief per instance model matrices, bound to the VAO as attributes 5-8
+  //----------------------------------------------------------------------------------------------------------------------
+  GLuint m_instanceBuffer=0;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief set to releaseGL by createVAO, null while the mesh has no GL objects
+  //----------------------------------------------------------------------------------------------------------------------
+  void (*m_releaseGL)(Mesh &)=nullptr;
 };
 
 
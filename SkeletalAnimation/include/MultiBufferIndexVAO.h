@@ -41,6 +41,14 @@ class  MultiBufferIndexVAO : public ngl::AbstractVAO
     virtual void setData(const VertexData &_data);
     void setData(size_t _size, const GLvoid *_data, GLenum _mode);
     void setIndices(unsigned int _indexSize,const GLvoid *_indexData,GLenum _indexType,GLenum _mode=GL_STATIC_DRAW);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief upload an index buffer of mixed index types as raw bytes, the caller passes the type and
+    /// byte offset of each range to its own draw calls so draw() can't be used with this buffer
+    /// @param _bytes the size of the data in bytes
+    /// @param _data the packed indices
+    /// @param _mode the draw mode hint used by GL
+    //----------------------------------------------------------------------------------------------------------------------
+    void setIndexBuffer(size_t _bytes,const GLvoid *_data,GLenum _mode=GL_STATIC_DRAW);
     void setVertexAttributePointer( GLuint _id,  GLint _size, GLenum _type, GLsizei _stride, unsigned int _dataOffset );
 
     //----------------------------------------------------------------------------------------------------------------------
@@ -66,9 +74,10 @@ class  MultiBufferIndexVAO : public ngl::AbstractVAO
     //----------------------------------------------------------------------------------------------------------------------
     GLuint m_buffer=0;
     //----------------------------------------------------------------------------------------------------------------------
-    /// @brief data type of the index data (e.g. GL_UNSIGNED_INT)
+    /// @brief data type of the index data (e.g. GL_UNSIGNED_INT), GL_NONE for a mixed buffer
+    /// set with setIndexBuffer
     //----------------------------------------------------------------------------------------------------------------------
-    GLenum m_indexType;
+    GLenum m_indexType=GL_NONE;
 
 
 };
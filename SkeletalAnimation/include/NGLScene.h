@@ -4,8 +4,14 @@
 #include <ngl/Text.h>
 #include <assimp/scene.h>
 #include "Mesh.h"
+#include "BonePaletteBuffer.h"
+#include "FrameScheduler.h"
+#include "PosePipeline.h"
+#include "UniformBinding.h"
 #include "WindowParams.h"
+#include "AssetManager.h"
 #include <QOpenGLWindow>
+#include <array>
 #include <memory>
 //----------------------------------------------------------------------------------------------------------------------
 /// @file NGLScene.h
@@ -25,9 +31,17 @@ class NGLScene : public QOpenGLWindow
   public:
     //----------------------------------------------------------------------------------------------------------------------
     /// @brief ctor for our NGL drawing class
-    /// @param [in] parent the parent window to the class
-    //----------------------------------------------------------------------------------------------------------------------
-    NGLScene(const char *_fname);
+    /// @param [in] _fname the file to load
+    /// @param [in] _crowdSize how many copies of the character to draw, each one plays the clip from a
+    /// different time and they are all drawn with one instanced draw per mesh
+    /// @param [in] _importFlags the assimp post process flags (see ImportProfile)
+    /// @param [in] _timeImport print the time taken by each import step
+    /// @param [in] _archive if set the file (and anything it references) is read from this archive
+    /// @param [in] _poseLatency 1 to evaluate the poses on a worker thread while the last frame's are drawn,
+    /// 0 to evaluate them in paintGL before drawing (see PosePipeline)
+    //----------------------------------------------------------------------------------------------------------------------
+    NGLScene(const char *_fname, size_t _crowdSize, unsigned int _importFlags, bool _timeImport=false,
+             std::shared_ptr<AssetArchive> _archive=nullptr, unsigned int _poseLatency=1);
     //----------------------------------------------------------------------------------------------------------------------
     /// @brief dtor must close down ngl and release OpenGL resources
     //----------------------------------------------------------------------------------------------------------------------
@@ -45,6 +59,13 @@ class NGLScene : public QOpenGLWindow
     /// @brief this is called everytime we resize the windows
     //----------------------------------------------------------------------------------------------------------------------
     void resizeGL(int _w, int _h);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief set the animation time and camera for a given frame rather than using the clock and mouse,
+    /// the clip is played at 60fps and the camera orbits the model once over the run
+    /// @param [in] _frame the frame to draw
+    /// @param [in] _numFrames how many frames are in the run
+    //----------------------------------------------------------------------------------------------------------------------
+    void setFixedFrame(size_t _frame, size_t _numFrames);
 
 
 private:
@@ -71,16 +92,109 @@ private:
     ngl::Vec3 m_modelPos;
     /// @brief flag to indicate if we are animating or not
     bool m_animate;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief drives the animation clock and asks for the next frame while animating
+    //----------------------------------------------------------------------------------------------------------------------
+    FrameScheduler m_scheduler;
     /// @brief
     float m_frameTime;
-    const aiScene* m_scene;
     std::string m_sceneName;
-    Assimp::Importer m_importer;
+    unsigned int m_importFlags;
+    bool m_timeImport=false;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief loads the model once however many characters use it
+    //----------------------------------------------------------------------------------------------------------------------
+    AssetManager m_assets;
     /// @brief the mesh to be animated, this will do all the animation and drawing
-    Mesh m_mesh;
+    std::shared_ptr<Mesh> m_mesh;
     size_t m_activeAnimation=0;
     size_t m_numAnimations;
     ngl::Mat4 m_rootTransform;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief number of characters in the crowd
+    //----------------------------------------------------------------------------------------------------------------------
+    size_t m_crowdSize=1;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief a character in the crowd, the mesh is shared and everything else is its own
+    //----------------------------------------------------------------------------------------------------------------------
+    struct Character
+    {
+      std::shared_ptr<Mesh> mesh;
+      /// @brief offset in seconds into the clip
+      float timeOffset=0.0f;
+      unsigned int clip=0;
+      /// @brief placement in the scene
+      ngl::Mat4 transform;
+      /// @brief the last pose asked for, and the last one evaluated with its bounds. A pose is only
+      /// evaluated when the clip or time changes so a paused crowd costs nothing
+      unsigned int poseClip=~0u;
+      float poseTime=0.0f;
+      std::vector<ngl::Mat4> palette;
+      ngl::Vec3 boundsMin;
+      ngl::Vec3 boundsMax;
+    };
+    std::vector<Character> m_crowd;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief evaluates the characters poses, this is after m_crowd so it is stopped before the meshes go
+    //----------------------------------------------------------------------------------------------------------------------
+    PosePipeline m_poses;
+    std::vector<PosePipeline::Job> m_poseJobs;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief false until the first poses have been collected, until then there is nothing to draw a frame late
+    //----------------------------------------------------------------------------------------------------------------------
+    bool m_posesPrimed=false;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief ask for the poses of every character whose clip or time has changed
+    /// @param [in] _time the animation time in seconds
+    //----------------------------------------------------------------------------------------------------------------------
+    void submitPoses(float _time);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief collect the last batch of poses and give them to their characters
+    /// @returns true if any character's pose changed
+    //----------------------------------------------------------------------------------------------------------------------
+    bool collectPoses();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the palettes and transforms of the characters that survived culling, these (and the GPU
+    /// copies) are only rebuilt when a pose or the set of visible characters changes
+    //----------------------------------------------------------------------------------------------------------------------
+    std::vector<ngl::Mat4> m_visiblePalettes;
+    std::vector<ngl::Mat4> m_visibleTransforms;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the characters drawn last frame sorted by LOD, used to tell if the visible set has changed
+    //----------------------------------------------------------------------------------------------------------------------
+    std::vector<size_t> m_visible;
+    std::vector<size_t> m_nextVisible;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief scratch for sorting the visible characters by LOD, kept to avoid allocating every frame
+    //----------------------------------------------------------------------------------------------------------------------
+    std::vector<unsigned int> m_cullLODs;
+    std::vector<size_t> m_sortedVisible;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief how many of the visible characters are at each LOD, these are consecutive in m_visible so
+    /// each level is one instanced draw
+    //----------------------------------------------------------------------------------------------------------------------
+    std::array<size_t,Simplify::s_maxLODs> m_lodCounts={};
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the first instance of the draw, used by the shader to find the palettes
+    //----------------------------------------------------------------------------------------------------------------------
+    UniformLocation m_instanceBase;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief texture buffer holding the bone palettes of all the drawn characters
+    //----------------------------------------------------------------------------------------------------------------------
+    std::unique_ptr<BonePaletteBuffer> m_palette;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief set once we have warned that the crowd is bigger than the palette texture can address
+    //----------------------------------------------------------------------------------------------------------------------
+    bool m_warnedCrowdLimit=false;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the camera and light uniform block
+    //----------------------------------------------------------------------------------------------------------------------
+    std::unique_ptr<FrameUniforms> m_frameUniforms;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief place the crowd on a grid and give each character its own start time
+    /// @param [in] _spacing distance between each character
+    //----------------------------------------------------------------------------------------------------------------------
+    void buildCrowd(float _spacing);
 
     //----------------------------------------------------------------------------------------------------------------------
     /// @brief method to load transform matrices to the shader
@@ -115,8 +229,10 @@ private:
     /// @param _event the Qt Event structure
     //----------------------------------------------------------------------------------------------------------------------
     void wheelEvent( QWheelEvent *_event);
-
-    void timerEvent(QTimerEvent *);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief print the frame interval stats from the scheduler
+    //----------------------------------------------------------------------------------------------------------------------
+    void printFrameStats() const;
 
 
 };
@@ -0,0 +1,90 @@
+#ifndef POSEPIPELINE_H_
+#define POSEPIPELINE_H_
+
+#include <ngl/Mat4.h>
+#include <ngl/Vec3.h>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class Mesh;
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @class PosePipeline
+/// @brief evaluates bone palettes (and their bounds) for a batch of characters. With a latency of one frame
+/// the batch is handed to a worker thread, which evaluates the next frame's poses while the GL thread uploads
+/// and draws the last ones, with a latency of 0 the batch is evaluated on the calling thread when submitted.
+/// Each frame call collect to get the results of the last submit then submit the next batch.
+//----------------------------------------------------------------------------------------------------------------------
+class PosePipeline
+{
+  public :
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief one pose to evaluate, the mesh must stay loaded until the job has been collected
+    //----------------------------------------------------------------------------------------------------------------------
+    struct Job
+    {
+      const Mesh *mesh=nullptr;
+      unsigned int clip=0;
+      float time=0.0f;
+      /// @brief for the caller to match the result to whatever asked for it
+      size_t id=0;
+      /// @brief the results
+      std::vector<ngl::Mat4> palette;
+      ngl::Vec3 boundsMin;
+      ngl::Vec3 boundsMax;
+    };
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief ctor
+    /// @param[in] _latency 1 to evaluate on a worker thread a frame ahead, 0 to evaluate when submitted
+    //----------------------------------------------------------------------------------------------------------------------
+    explicit PosePipeline(unsigned int _latency=1);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief dtor waits for any batch in flight and stops the worker
+    //----------------------------------------------------------------------------------------------------------------------
+    ~PosePipeline();
+    PosePipeline(const PosePipeline &)=delete;
+    PosePipeline &operator=(const PosePipeline &)=delete;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief start evaluating a batch, the jobs are swapped into the pipeline so no palettes are copied and
+    /// io_jobs is given back the storage of an older batch to fill next time. Each submit must be followed
+    /// by a collect before the next one
+    /// @param[in,out] io_jobs the batch to evaluate
+    //----------------------------------------------------------------------------------------------------------------------
+    void submit(std::vector<Job> &io_jobs);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief wait for the last submitted batch and swap it into o_jobs, if nothing was submitted o_jobs is
+    /// left empty
+    /// @param[out] o_jobs the evaluated batch
+    //----------------------------------------------------------------------------------------------------------------------
+    void collect(std::vector<Job> &o_jobs);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the number of frames between submitting a batch and it being used
+    //----------------------------------------------------------------------------------------------------------------------
+    unsigned int latency() const { return m_latency; }
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief evaluate one job, this is what the worker runs
+    //----------------------------------------------------------------------------------------------------------------------
+    static void evaluate(Job &io_job);
+
+  private :
+    void workerLoop();
+    unsigned int m_latency;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the batch in flight (or finished and waiting to be collected)
+    //----------------------------------------------------------------------------------------------------------------------
+    std::vector<Job> m_batch;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief set by submit, m_busy is cleared by the worker when the batch is done
+    //----------------------------------------------------------------------------------------------------------------------
+    bool m_submitted=false;
+    bool m_busy=false;
+    bool m_stop=false;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+    std::thread m_worker;
+};
+
+#endif
@@ -0,0 +1,153 @@
+#ifndef PROFILER_H_
+#define PROFILER_H_
+
+#include <ngl/Types.h>
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @file Profiler.h
+/// @brief a small frame profiler with CPU and GPU scopes. CPU scopes are timed with std::chrono, GPU
+/// scopes with GL_TIME_ELAPSED queries. The queries are double buffered and only read back two frames
+/// later (and dropped if still not ready) so the profiler never stalls the pipeline.
+/// Use the PROFILE_ macros rather than the class directly, if PROFILER_ENABLED is not defined they
+/// expand to nothing so there is no cost at all.
+//----------------------------------------------------------------------------------------------------------------------
+class Profiler
+{
+  public :
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief a single timed scope, names must be string literals as only the pointer is kept
+    //----------------------------------------------------------------------------------------------------------------------
+    struct Event
+    {
+      const char *name;
+      /// @brief start in micro seconds from the first frame
+      double start;
+      /// @brief duration in micro seconds (-1 for a GPU scope that has not been read back yet)
+      double duration;
+      bool gpu;
+    };
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief everything recorded in one frame
+    //----------------------------------------------------------------------------------------------------------------------
+    struct Frame
+    {
+      uint64_t index=0;
+      double start=0.0;
+      /// @brief time from beginFrame to endFrame (including the swap) in ms
+      double cpuMs=0.0;
+      /// @brief sum of the GPU scopes in ms, only valid once gpuResolved is set
+      double gpuMs=0.0;
+      bool gpuResolved=false;
+      std::vector<Event> events;
+    };
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief how many frames are kept in the ring buffer
+    //----------------------------------------------------------------------------------------------------------------------
+    static constexpr size_t s_historySize=300;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief times a CPU scope from construction to destruction
+    //----------------------------------------------------------------------------------------------------------------------
+    class CPUScope
+    {
+      public :
+        explicit CPUScope(const char *_name);
+        ~CPUScope();
+        CPUScope(const CPUScope &)=delete;
+        CPUScope &operator=(const CPUScope &)=delete;
+      private :
+        const char *m_name;
+        double m_start;
+    };
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief times a GPU scope with a GL_TIME_ELAPSED query, GL only allows one of these to be active
+    /// at a time so a GPU scope opened inside another one is ignored
+    //----------------------------------------------------------------------------------------------------------------------
+    class GPUScope
+    {
+      public :
+        explicit GPUScope(const char *_name);
+        ~GPUScope();
+        GPUScope(const GPUScope &)=delete;
+        GPUScope &operator=(const GPUScope &)=delete;
+      private :
+        bool m_active=false;
+    };
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief start a new frame, this also collects any GPU results that are ready. Needs a GL context
+    //----------------------------------------------------------------------------------------------------------------------
+    static void beginFrame();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief mark the end of our drawing, the time from here to endFrame is recorded as the swap
+    //----------------------------------------------------------------------------------------------------------------------
+    static void beginSwap();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief finish the frame, call once the buffers have been swapped (QOpenGLWindow::frameSwapped)
+    //----------------------------------------------------------------------------------------------------------------------
+    static void endFrame();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief access the history, 0 is the current frame, 1 the one before etc.
+    /// @param[in] _framesAgo how far back to look must be less than historySize()
+    //----------------------------------------------------------------------------------------------------------------------
+    static const Frame &frame(size_t _framesAgo);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief how many frames are actually in the history
+    //----------------------------------------------------------------------------------------------------------------------
+    static size_t historySize();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief write the history in the Chrome trace_event format, load it in chrome://tracing or
+    /// https://ui.perfetto.dev CPU scopes are on thread 1 and GPU scopes on thread 2
+    /// @param[in] _fname the file to write
+    /// @returns true on success
+    //----------------------------------------------------------------------------------------------------------------------
+    static bool writeChromeTrace(const std::string &_fname);
+
+  private :
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief a GPU query waiting to be read back, frame and event are where the result goes
+    //----------------------------------------------------------------------------------------------------------------------
+    struct PendingQuery
+    {
+      GLuint query;
+      uint64_t frame;
+      size_t event;
+    };
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief read back the queries issued in _set, anything not ready is dropped
+    //----------------------------------------------------------------------------------------------------------------------
+    static void resolveQueries(size_t _set);
+    static double now();
+    static Frame &current();
+    static void record(const char *_name, double _start, double _duration, bool _gpu);
+
+    static std::array<Frame,s_historySize> s_frames;
+    static uint64_t s_frameIndex;
+    static double s_swapStart;
+    static bool s_gpuScopeActive;
+    /// @brief the two sets of queries (this frame and the last one) and the pool of free query objects
+    static std::array<std::vector<PendingQuery>,2> s_pending;
+    static std::vector<GLuint> s_freeQueries;
+};
+
+#ifdef PROFILER_ENABLED
+  #define PROFILE_CONCAT_IMPL(a,b) a##b
+  #define PROFILE_CONCAT(a,b) PROFILE_CONCAT_IMPL(a,b)
+  #define PROFILE_CPU(name) Profiler::CPUScope PROFILE_CONCAT(cpuScope,__LINE__)(name)
+  #define PROFILE_GPU(name) Profiler::GPUScope PROFILE_CONCAT(gpuScope,__LINE__)(name)
+  #define PROFILE_BEGIN_FRAME() Profiler::beginFrame()
+  #define PROFILE_BEGIN_SWAP() Profiler::beginSwap()
+  #define PROFILE_END_FRAME() Profiler::endFrame()
+  #define PROFILE_WRITE_TRACE(fname) Profiler::writeChromeTrace(fname)
+#else
+  #define PROFILE_CPU(name) ((void)0)
+  #define PROFILE_GPU(name) ((void)0)
+  #define PROFILE_BEGIN_FRAME() ((void)0)
+  #define PROFILE_BEGIN_SWAP() ((void)0)
+  #define PROFILE_END_FRAME() ((void)0)
+  #define PROFILE_WRITE_TRACE(fname) ((void)0)
+#endif
+
+#endif
@@ -0,0 +1,33 @@
+#ifndef SHADERCACHE_H_
+#define SHADERCACHE_H_
+#include <string>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief builds ShaderLib programs from a vertex and fragment shader, keeping the linked binary
+/// (glGetProgramBinary) on disk so later runs can skip compiling and linking. The cache file is keyed by
+/// a hash of both sources and the GL vendor, renderer and version strings so an edited shader or a driver
+/// update gives a new entry. If the driver rejects a binary the program is built from source as normal
+/// and the cache entry replaced. The time taken is printed either way.
+//----------------------------------------------------------------------------------------------------------------------
+namespace ShaderCache
+{
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief create and link a program with ShaderLib, needs a current GL context
+  /// @param[in] _program the ShaderLib name of the program, the shaders are called _program+"Vertex"
+  /// and _program+"Fragment"
+  /// @param[in] _vertexFile the vertex shader source file
+  /// @param[in] _fragmentFile the fragment shader source file
+  /// @returns true if the program is linked
+  //----------------------------------------------------------------------------------------------------------------------
+  extern bool loadProgram(const std::string &_program, const std::string &_vertexFile, const std::string &_fragmentFile);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief turn the cache on or off (on by default), when off programs are always built from source
+  //----------------------------------------------------------------------------------------------------------------------
+  extern void setEnabled(bool _enabled);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief where the binaries are kept, default "shadercache" next to the executable's working dir
+  //----------------------------------------------------------------------------------------------------------------------
+  extern void setDirectory(const std::string &_dir);
+}
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef TIMINGSUMMARY_H_
+#define TIMINGSUMMARY_H_
+#include <cstddef>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief the min / median / p99 summary printed by the headless renderers and written by AssetBench
+//----------------------------------------------------------------------------------------------------------------------
+namespace TimingSummary
+{
+  struct Summary
+  {
+    double total=0.0;
+    double mean=0.0;
+    double min=0.0;
+    double median=0.0;
+    double p99=0.0;
+    size_t samples=0;
+  };
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief summarise a set of times, the percentile is nearest rank
+  /// @param[in] _times the samples in any order and any unit, the summary is in the same unit
+  //----------------------------------------------------------------------------------------------------------------------
+  extern Summary summarise(std::vector<double> _times);
+}
+
+#endif
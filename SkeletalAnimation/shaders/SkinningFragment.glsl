@@ -23,7 +23,16 @@ struct Lights
 // @param material passed from our program
 uniform Materials material;
 
-uniform Lights light;
+/// @brief the camera and light, shared by every program and updated once per frame (see FrameUniforms)
+layout (std140) uniform FrameBlock
+{
+	mat4 MV;
+	mat4 MVP;
+	mat4 M;
+	mat4 normalMatrix;
+	vec4 viewerPos;
+	Lights light;
+};
 in vec3 lightDir;
 // out the blinn half vector
 in vec3 halfVector;
@@ -0,0 +1,38 @@
+#include "ArchiveIOSystem.h"
+#include <assimp/MemoryIOWrapper.h>
+#include <cstring>
+
+ArchiveIOSystem::ArchiveIOSystem(std::shared_ptr<AssetArchive> _archive) : m_archive(std::move(_archive))
+{
+}
+
+bool ArchiveIOSystem::Exists(const char *_file) const
+{
+  return m_archive->find(_file) != nullptr;
+}
+
+char ArchiveIOSystem::getOsSeparator() const
+{
+  // names in the archive always use /
+  return '/';
+}
+
+Assimp::IOStream *ArchiveIOSystem::Open(const char *_file, const char *_mode)
+{
+  if (std::strchr(_mode, 'w') != nullptr || std::strchr(_mode, 'a') != nullptr)
+  {
+    return nullptr;
+  }
+  const AssetArchive::Entry *entry = m_archive->find(_file);
+  if (entry == nullptr)
+  {
+    return nullptr;
+  }
+  // the stream doesn't own the data, the archive (which we keep alive) does
+  return new Assimp::MemoryIOStream(entry->data, entry->size, false);
+}
+
+void ArchiveIOSystem::Close(Assimp::IOStream *_file)
+{
+  delete _file;
+}
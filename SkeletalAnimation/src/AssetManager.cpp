@@ -0,0 +1,128 @@
+#include "AssetManager.h"
+#include "ArchiveIOSystem.h"
+#include "ImportProfile.h"
+#include "MappedIOSystem.h"
+#include <functional>
+#include <iostream>
+#include <vector>
+
+AssetManager::AssetManager(std::shared_ptr<AssetArchive> _archive) : m_archive(std::move(_archive))
+{
+}
+
+size_t AssetManager::KeyHash::operator()(const Key &_k) const
+{
+  // the content hash is already well mixed so just fold the rest in
+  return static_cast<size_t>(_k.hash ^ (std::hash<std::string>()(_k.path) * 31u) ^ _k.flags);
+}
+
+bool AssetManager::contentHash(const std::string &_fname, uint64_t &o_hash)
+{
+  if (m_archive)
+  {
+    const AssetArchive::Entry *entry = m_archive->find(_fname);
+    if (entry == nullptr)
+    {
+      return false;
+    }
+    o_hash = entry->hash;
+    return true;
+  }
+  // a crowd asks for the same file over and over, don't read it every time
+  std::error_code error;
+  FileStamp stamp;
+  stamp.size = std::filesystem::file_size(_fname, error);
+  if (!error)
+  {
+    stamp.time = std::filesystem::last_write_time(_fname, error);
+  }
+  auto known = m_stamps.find(_fname);
+  if (!error && known != m_stamps.end() && known->second.size == stamp.size && known->second.time == stamp.time)
+  {
+    o_hash = known->second.hash;
+    return true;
+  }
+  MappedIOSystem io;
+  std::unique_ptr<Assimp::IOStream> stream(io.Open(_fname.c_str(), "rb"));
+  if (!stream)
+  {
+    return false;
+  }
+  size_t size = stream->FileSize();
+  // mapped files can be hashed in place, anything else is read in
+  if (auto mapped = dynamic_cast<MappedIOStream *>(stream.get()))
+  {
+    o_hash = AssetArchive::hash(mapped->data(), size);
+  }
+  else
+  {
+    std::vector<uint8_t> data(size);
+    if (size != 0 && stream->Read(data.data(), 1, size) != size)
+    {
+      return false;
+    }
+    o_hash = AssetArchive::hash(data.data(), size);
+  }
+  if (!error)
+  {
+    stamp.hash = o_hash;
+    m_stamps[_fname] = stamp;
+  }
+  return true;
+}
+
+std::shared_ptr<Mesh> AssetManager::load(const std::string &_fname, unsigned int _flags, bool _timeSteps)
+{
+  Key key;
+  key.path = AssetArchive::normalise(_fname);
+  key.flags = _flags;
+  if (!contentHash(_fname, key.hash))
+  {
+    std::cerr << "unable to read " << _fname << "\n";
+    return nullptr;
+  }
+  auto cached = m_assets.find(key);
+  if (cached != m_assets.end())
+  {
+    if (auto asset = cached->second.lock())
+    {
+      ++m_hits;
+      // the handle points at the mesh but keeps the whole asset (and its scene) alive
+      return std::shared_ptr<Mesh>(asset, &asset->mesh);
+    }
+  }
+  ++m_misses;
+  auto asset = std::make_shared<Asset>();
+  // the importer owns (and deletes) the IO system
+  if (m_archive)
+  {
+    asset->importer.SetIOHandler(new ArchiveIOSystem(m_archive));
+  }
+  else
+  {
+    asset->importer.SetIOHandler(new MappedIOSystem);
+  }
+  const aiScene *scene = ImportProfile::readFile(asset->importer, _fname, _flags, _timeSteps);
+  if (scene == nullptr || !asset->mesh.load(scene, _timeSteps))
+  {
+    std::cerr << "Assimp reports " << asset->importer.GetErrorString() << "\n";
+    return nullptr;
+  }
+  // drop anything that has been released before adding the new one
+  for (auto it = m_assets.begin(); it != m_assets.end();)
+  {
+    it = it->second.expired() ? m_assets.erase(it) : std::next(it);
+  }
+  m_assets[key] = asset;
+  return std::shared_ptr<Mesh>(asset, &asset->mesh);
+}
+
+size_t AssetManager::liveAssets() const
+{
+  size_t count = 0;
+  for (auto &a : m_assets)
+  {
+    count += a.second.expired() ? 0 : 1;
+  }
+  return count;
+}
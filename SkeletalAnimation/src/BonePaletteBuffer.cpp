@@ -0,0 +1,60 @@
+#include "BonePaletteBuffer.h"
+#include "RenderStats.h"
+#include <iostream>
+
+BonePaletteBuffer::BonePaletteBuffer()
+{
+  glGenBuffers(1, &m_buffer);
+  glBindBuffer(GL_TEXTURE_BUFFER, m_buffer);
+  // allocate a single matrix so the texture is valid before the first upload
+  ngl::Mat4 identity(1.0f);
+  glBufferData(GL_TEXTURE_BUFFER, sizeof(ngl::Mat4), &identity.m_00, GL_STREAM_DRAW);
+  glGenTextures(1, &m_texture);
+  glBindTexture(GL_TEXTURE_BUFFER, m_texture);
+  glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, m_buffer);
+  glBindTexture(GL_TEXTURE_BUFFER, 0);
+  glBindBuffer(GL_TEXTURE_BUFFER, 0);
+  // the limit is in texels and each matrix takes 4, it only changes with the context so ask once
+  GLint maxTexels = 0;
+  glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+  m_capacity = static_cast<size_t>(maxTexels) / 4;
+}
+
+BonePaletteBuffer::~BonePaletteBuffer()
+{
+  glDeleteTextures(1, &m_texture);
+  glDeleteBuffers(1, &m_buffer);
+}
+
+void BonePaletteBuffer::upload(const std::vector<ngl::Mat4> &_palettes)
+{
+  if (_palettes.empty())
+  {
+    return;
+  }
+  m_size = _palettes.size();
+  if (m_size > m_capacity)
+  {
+    // anything past the limit would be unreadable by the shader so drop it rather than fail silently
+    if (!m_warned)
+    {
+      std::cerr << "BonePaletteBuffer : " << m_size << " matrices exceeds GL_MAX_TEXTURE_BUFFER_SIZE, only "
+                << m_capacity << " will be uploaded\n";
+      m_warned = true;
+    }
+    m_size = m_capacity;
+  }
+  auto bytes = static_cast<GLsizeiptr>(m_size * sizeof(ngl::Mat4));
+  glBindBuffer(GL_TEXTURE_BUFFER, m_buffer);
+  // orphan the old storage then fill the new one
+  glBufferData(GL_TEXTURE_BUFFER, bytes, nullptr, GL_STREAM_DRAW);
+  glBufferSubData(GL_TEXTURE_BUFFER, 0, bytes, &_palettes[0].m_00);
+  RenderStats::addBufferBytes(static_cast<size_t>(bytes));
+  glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+void BonePaletteBuffer::bind(GLuint _unit) const
+{
+  glActiveTexture(GL_TEXTURE0 + _unit);
+  glBindTexture(GL_TEXTURE_BUFFER, m_texture);
+}
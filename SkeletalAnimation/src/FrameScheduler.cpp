@@ -0,0 +1,68 @@
+#include "FrameScheduler.h"
+#include <algorithm>
+#include <cmath>
+
+FrameScheduler::FrameScheduler(double _step) : m_step(_step)
+{
+}
+
+void FrameScheduler::setAnimating(bool _animating)
+{
+  m_animating = _animating;
+  // the next frame starts the clock again rather than counting the time we were stopped
+  m_continuous = false;
+}
+
+void FrameScheduler::beginFrame()
+{
+  auto now = Clock::now();
+  m_steps = 0;
+  if (!m_animating)
+  {
+    m_lastFrame = now;
+    return;
+  }
+  if (m_continuous)
+  {
+    double interval = std::chrono::duration<double>(now - m_lastFrame).count();
+    m_intervals[m_nextInterval] = interval * 1000.0;
+    m_nextInterval = (m_nextInterval + 1) % s_window;
+    m_numIntervals = std::min(m_numIntervals + 1, s_window);
+    m_accumulator += std::min(interval, s_maxFrameTime);
+    while (m_accumulator >= m_step)
+    {
+      m_accumulator -= m_step;
+      m_time += m_step;
+      ++m_steps;
+    }
+  }
+  m_lastFrame = now;
+  m_continuous = true;
+}
+
+FrameScheduler::Stats FrameScheduler::stats() const
+{
+  Stats s;
+  s.frames = m_numIntervals;
+  if (m_numIntervals == 0)
+  {
+    return s;
+  }
+  s.min = m_intervals[0];
+  s.max = m_intervals[0];
+  double sum = 0.0;
+  for (size_t i = 0; i < m_numIntervals; ++i)
+  {
+    sum += m_intervals[i];
+    s.min = std::min(s.min, m_intervals[i]);
+    s.max = std::max(s.max, m_intervals[i]);
+  }
+  s.mean = sum / m_numIntervals;
+  double variance = 0.0;
+  for (size_t i = 0; i < m_numIntervals; ++i)
+  {
+    variance += (m_intervals[i] - s.mean) * (m_intervals[i] - s.mean);
+  }
+  s.jitter = std::sqrt(variance / m_numIntervals);
+  return s;
+}
@@ -0,0 +1,80 @@
+#include "HeadlessRenderer.h"
+#include "NGLScene.h"
+#include "Profiler.h"
+#include "TimingSummary.h"
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+HeadlessRenderer::HeadlessRenderer(const QSurfaceFormat &_format, int _width, int _height)
+  : m_width(_width), m_height(_height)
+{
+  m_context.setFormat(_format);
+  if (!m_context.create())
+  {
+    std::cerr << "Unable to create an OpenGL context\n";
+    return;
+  }
+  m_surface.setFormat(m_context.format());
+  m_surface.create();
+  if (!m_surface.isValid() || !m_context.makeCurrent(&m_surface))
+  {
+    std::cerr << "Unable to create an offscreen surface\n";
+    return;
+  }
+  // no multisampling so the images are the same from run to run and driver to driver
+  QOpenGLFramebufferObjectFormat fboFormat;
+  fboFormat.setAttachment(QOpenGLFramebufferObject::CombinedDepthStencil);
+  fboFormat.setSamples(0);
+  m_fbo = std::make_unique<QOpenGLFramebufferObject>(m_width, m_height, fboFormat);
+  if (!m_fbo->isValid())
+  {
+    std::cerr << "Unable to create a " << m_width << "x" << m_height << " framebuffer\n";
+    return;
+  }
+  m_valid = true;
+}
+
+int HeadlessRenderer::run(NGLScene &_scene, size_t _frames, const std::string &_snapshot)
+{
+  m_fbo->bind();
+  _scene.initializeGL();
+  _scene.resizeGL(m_width, m_height);
+  std::cout << "Headless renderer " << glGetString(GL_RENDERER) << " " << glGetString(GL_VERSION) << "\n";
+
+  std::vector<double> times;
+  times.reserve(_frames);
+  for (size_t i = 0; i < _frames; ++i)
+  {
+    _scene.setFixedFrame(i, _frames);
+    auto start = std::chrono::steady_clock::now();
+    _scene.paintGL();
+    // wait for the GPU so the time covers the whole frame not just the CPU submission
+    glFinish();
+    auto end = std::chrono::steady_clock::now();
+    PROFILE_END_FRAME();
+    times.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+    std::cout << "frame " << i << " " << times.back() << " ms\n";
+  }
+  if (!times.empty())
+  {
+    auto summary = TimingSummary::summarise(times);
+    std::cout << "frames " << summary.samples
+              << " mean " << summary.mean << " ms"
+              << " min " << summary.min << " ms"
+              << " median " << summary.median << " ms"
+              << " p99 " << summary.p99 << " ms"
+              << " fps " << 1000.0 * summary.samples / summary.total << "\n";
+  }
+  if (!_snapshot.empty())
+  {
+    if (!m_fbo->toImage().save(QString::fromStdString(_snapshot)))
+    {
+      std::cerr << "Unable to save " << _snapshot << "\n";
+      return EXIT_FAILURE;
+    }
+    std::cout << "saved last frame to " << _snapshot << "\n";
+  }
+  m_fbo->release();
+  return EXIT_SUCCESS;
+}
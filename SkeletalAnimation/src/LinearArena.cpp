@@ -0,0 +1,52 @@
+#include "LinearArena.h"
+#include <cstdint>
+
+LinearArena::LinearArena(size_t _blockSize) : m_blockSize(_blockSize)
+{
+}
+
+void *LinearArena::allocate(size_t _bytes, size_t _alignment)
+{
+  auto address = reinterpret_cast<uintptr_t>(m_current);
+  size_t padding = (_alignment - (address & (_alignment - 1))) & (_alignment - 1);
+  if (m_current == nullptr || padding + _bytes > m_remaining)
+  {
+    // new[] of bytes is only aligned to max_align_t so leave room to align up
+    if (_bytes + _alignment > m_blockSize)
+    {
+      // too big for a normal block, give it one of its own and keep bumping from the current block
+      // so its free space isn't thrown away
+      size_t size = _bytes + _alignment;
+      m_blocks.emplace_back(new std::byte[size]);
+      ++m_stats.blocks;
+      m_stats.blockBytes += size;
+      auto block = reinterpret_cast<uintptr_t>(m_blocks.back().get());
+      std::byte *result = m_blocks.back().get() + ((_alignment - (block & (_alignment - 1))) & (_alignment - 1));
+      ++m_stats.allocations;
+      m_stats.bytes += _bytes;
+      return result;
+    }
+    size_t size = m_blockSize;
+    m_blocks.emplace_back(new std::byte[size]);
+    m_current = m_blocks.back().get();
+    m_remaining = size;
+    ++m_stats.blocks;
+    m_stats.blockBytes += size;
+    address = reinterpret_cast<uintptr_t>(m_current);
+    padding = (_alignment - (address & (_alignment - 1))) & (_alignment - 1);
+  }
+  std::byte *result = m_current + padding;
+  m_current = result + _bytes;
+  m_remaining -= padding + _bytes;
+  ++m_stats.allocations;
+  m_stats.bytes += _bytes;
+  return result;
+}
+
+void LinearArena::release()
+{
+  m_blocks.clear();
+  m_current = nullptr;
+  m_remaining = 0;
+  m_stats = Stats();
+}
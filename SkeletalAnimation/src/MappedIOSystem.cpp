@@ -0,0 +1,113 @@
+#include "MappedIOSystem.h"
+#include <algorithm>
+#include <cstring>
+#ifndef _WIN32
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+MappedIOStream::MappedIOStream(const uint8_t *_data, size_t _size) : m_data(_data), m_size(_size)
+{
+}
+
+MappedIOStream::~MappedIOStream()
+{
+#ifndef _WIN32
+  if (m_data != nullptr)
+  {
+    munmap(const_cast<uint8_t *>(m_data), m_size);
+  }
+#endif
+}
+
+size_t MappedIOStream::Read(void *o_buffer, size_t _size, size_t _count)
+{
+  if (_size == 0 || _count == 0)
+  {
+    return 0;
+  }
+  // like fread only whole elements are returned
+  size_t count = std::min(_count, (m_size - m_pos) / _size);
+  size_t bytes = count * _size;
+  std::memcpy(o_buffer, m_data + m_pos, bytes);
+  m_pos += bytes;
+  return count;
+}
+
+size_t MappedIOStream::Write(const void *, size_t, size_t)
+{
+  return 0;
+}
+
+aiReturn MappedIOStream::Seek(size_t _offset, aiOrigin _origin)
+{
+  size_t pos;
+  switch (_origin)
+  {
+    case aiOrigin_SET : pos = _offset; break;
+    case aiOrigin_CUR : pos = m_pos + _offset; break;
+    case aiOrigin_END : pos = m_size - _offset; break;
+    default : return aiReturn_FAILURE;
+  }
+  if (pos > m_size)
+  {
+    return aiReturn_FAILURE;
+  }
+  m_pos = pos;
+  return aiReturn_SUCCESS;
+}
+
+size_t MappedIOStream::Tell() const
+{
+  return m_pos;
+}
+
+size_t MappedIOStream::FileSize() const
+{
+  return m_size;
+}
+
+void MappedIOStream::Flush()
+{
+}
+
+Assimp::IOStream *MappedIOSystem::Open(const char *_file, const char *_mode)
+{
+#ifndef _WIN32
+  if (_file == nullptr || _mode == nullptr || std::strchr(_mode, 'w') || std::strchr(_mode, 'a') || std::strchr(_mode, '+'))
+  {
+    return DefaultIOSystem::Open(_file, _mode);
+  }
+  int fd = open(_file, O_RDONLY);
+  if (fd < 0)
+  {
+    return nullptr;
+  }
+  struct stat info;
+  if (fstat(fd, &info) != 0)
+  {
+    close(fd);
+    return nullptr;
+  }
+  size_t size = static_cast<size_t>(info.st_size);
+  void *data = nullptr;
+  if (size > 0)
+  {
+    data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED)
+    {
+      close(fd);
+      // can't map it (a pipe or special file) so let stdio try
+      return DefaultIOSystem::Open(_file, _mode);
+    }
+    madvise(data, size, MADV_SEQUENTIAL);
+  }
+  // the mapping holds its own reference to the file
+  close(fd);
+  return new MappedIOStream(static_cast<const uint8_t *>(data), size);
+#else
+  return DefaultIOSystem::Open(_file, _mode);
+#endif
+}
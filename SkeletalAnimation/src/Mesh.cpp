@@ -2,11 +2,13 @@
 #include "AIUtil.h"
 #include <ngl/Util.h>
 #include <ngl/NGLInit.h>
+#include <algorithm>
 #include <cassert>
+#include <cmath>
 #include <iostream>
-#include <ngl/AbstractVAO.h>
-#include <ngl/VAOFactory.h>
-#include "MultiBufferIndexVAO.h"
+
+// the LODs and the direct upload read the aiMesh vertex arrays as packed floats
+static_assert(sizeof(aiVector3D) == 3 * sizeof(float), "assimp must be built with single precision");
 /// @note this is based on several demos and converted to NGL
 /// http://ogldev.atspace.co.uk/www/tutorial38/tutorial38.html
 /// http://zylinski.se
@@ -40,21 +42,21 @@ Mesh::~Mesh()
   clear();
 }
 
-bool Mesh::load(const aiScene *_scene)
+bool Mesh::loadData(const aiScene *_scene, GeometryData &o_data)
 {
   bool success = false;
   m_scene = _scene;
-  m_numAnimations = _scene->mNumAnimations;
-  // we have already forced the load to be trinagles so no need to check
-  m_vao = ngl::VAOFactory::createVAO("multiBufferIndexVAO", GL_TRIANGLES);
+  // any cached pose belongs to the old scene
+  m_poseAnimation = s_noPose;
   // if we have a valid scene load and init
   if (m_scene)
   {
+    m_numAnimations = _scene->mNumAnimations;
     // grab the inverse global transform
     m_globalInverseTransform = AIU::aiMatrix4x4ToNGLMat4(m_scene->mRootNode->mTransformation);
     m_globalInverseTransform.inverse();
     // now load the bones etc
-    initFromScene(m_scene);
+    initFromScene(m_scene, o_data);
     success = true;
   }
   else
@@ -64,52 +66,74 @@ bool Mesh::load(const aiScene *_scene)
   return success;
 }
 
-void Mesh::render() const
+bool Mesh::boneTransform(float _timeInSeconds, std::vector<ngl::Mat4> &o_transforms)
 {
-  m_vao->bind();
-  /// unsigned int size=m_entries.size();
-  // for (unsigned int i = 0 ; i < size; ++i)
-  for (auto entry : m_entries)
+  return boneTransform(_timeInSeconds, o_transforms, m_activeAnimations);
+}
+
+bool Mesh::boneTransform(float _timeInSeconds, std::vector<ngl::Mat4> &o_transforms, unsigned int _animation)
+{
+  // the same pose as last time, nothing to evaluate
+  float time = animationTime(_timeInSeconds, _animation);
+  if (_animation == m_poseAnimation && time == m_poseTime)
   {
-    // whist we have the data stored in our VAO structure we only need to bind to re-activate the
-    // attribute data, then we draw using ElemetsBaseVertex. This is similar to how the
-    // sponza demo works, really if you were dealing with different model textures etc this would
-    // also be switched here for each of the different mesh entries.
-    glDrawElementsBaseVertex(GL_TRIANGLES,
-                             entry.NumIndices,
-                             GL_UNSIGNED_INT,
-                             (void *)(sizeof(unsigned int) * entry.BaseIndex),
-                             entry.BaseVertex);
-
-    // seems that BaseVertex isn't under linux (not sure why) this works as well but doesn't
-    // cope with embedded meshes so well
-    //  glDrawElements(GL_TRIANGLES,
-    //                           m_entries[i].NumIndices,
-    //                           GL_UNSIGNED_INT,
-    //                           (void*)(sizeof(unsigned int) * m_entries[i].BaseIndex)
-    //                           );
+    o_transforms = m_posePalette;
+    return false;
   }
-  m_vao->unbind();
+  evaluatePose(_timeInSeconds, _animation, o_transforms);
+  m_poseAnimation = _animation;
+  m_poseTime = time;
+  m_posePalette = o_transforms;
+  return true;
 }
 
-void Mesh::boneTransform(float _timeInSeconds, std::vector<ngl::Mat4> &o_transforms)
+float Mesh::animationTime(float _timeInSeconds, unsigned int _animation) const
 {
-  ngl::Mat4 identity(1.0);
-  // calculate the current animation time at present this is set to only one animation in the scene and
-  // hard coded to animaiton 0 but if we have more we would set it to the proper animation data
-  float ticksPerSecond = m_scene->mAnimations[m_activeAnimations]->mTicksPerSecond != 0 ? m_scene->mAnimations[0]->mTicksPerSecond : 25.0f;
+  // calculate the current animation time for the requested clip
+  const aiAnimation *animation = m_scene->mAnimations[_animation];
+  float ticksPerSecond = animation->mTicksPerSecond != 0 ? animation->mTicksPerSecond : 25.0f;
   float timeInTicks = _timeInSeconds * ticksPerSecond;
-  float animationTime = fmod(timeInTicks, m_scene->mAnimations[m_activeAnimations]->mDuration);
-  // now traverse the animaiton heirarchy and get the transforms for the bones
-  recurseNodeHeirarchy(animationTime, m_scene->mRootNode, identity);
+  return fmod(timeInTicks, animation->mDuration);
+}
+
+void Mesh::evaluatePose(float _timeInSeconds, unsigned int _animation, std::vector<ngl::Mat4> &o_transforms) const
+{
+  ngl::Mat4 identity(1.0);
   o_transforms.resize(m_numBones);
+  // now traverse the animaiton heirarchy and get the transforms for the bones
+  recurseNodeHeirarchy(animationTime(_timeInSeconds, _animation), m_scene->mAnimations[_animation],
+                       m_scene->mRootNode, identity, o_transforms);
+}
 
-  for (unsigned int i = 0; i < m_numBones; ++i)
+void Mesh::getAnimatedBounds(const std::vector<ngl::Mat4> &_transforms, ngl::Vec3 &o_min, ngl::Vec3 &o_max) const
+{
+  o_min.set(1e10f, 1e10f, 1e10f);
+  o_max.set(-1e10f, -1e10f, -1e10f);
+  auto size = std::min(_transforms.size(), m_boneInfo.size());
+  for (size_t i = 0; i < size; ++i)
   {
-    // now copy this data note that we need to transpose for NGL useage
-    // this data will be copied to the shader and used in the animation skinning
-    // process
-    o_transforms[i] = m_boneInfo[i].finalTransformation.transpose();
+    const BoneInfo &info = m_boneInfo[i];
+    if (info.hasBounds == false)
+    {
+      continue;
+    }
+    // the palette is in the layout uploaded to the shader (translation in m_m[3]) so move the box
+    // centre and project the half extents onto each axis (Arvo's method) rather than doing 8 corners
+    const ngl::Mat4 &m = _transforms[i];
+    ngl::Vec3 centre = (info.boundsMin + info.boundsMax) * 0.5f;
+    ngl::Vec3 extent = (info.boundsMax - info.boundsMin) * 0.5f;
+    for (int axis = 0; axis < 3; ++axis)
+    {
+      float c = m.m_m[3][axis] +
+                m.m_m[0][axis] * centre.m_x +
+                m.m_m[1][axis] * centre.m_y +
+                m.m_m[2][axis] * centre.m_z;
+      float e = std::abs(m.m_m[0][axis]) * extent.m_x +
+                std::abs(m.m_m[1][axis]) * extent.m_y +
+                std::abs(m.m_m[2][axis]) * extent.m_z;
+      o_min[axis] = std::min(o_min[axis], c - e);
+      o_max[axis] = std::max(o_max[axis], c + e);
+    }
   }
 }
 
@@ -199,7 +223,7 @@ ngl::Vec3 Mesh::calcInterpolatedPosition(float _animationTime, const aiNodeAnim
   return ngl::lerp(start, end, factor);
 }
 
-const aiNodeAnim *Mesh::findNodeAnim(const aiAnimation *_animation, const std::string &_nodeName)
+const aiNodeAnim *Mesh::findNodeAnim(const aiAnimation *_animation, const std::string &_nodeName) const
 {
   for (unsigned int i = 0; i < _animation->mNumChannels; ++i)
   {
@@ -214,15 +238,14 @@ const aiNodeAnim *Mesh::findNodeAnim(const aiAnimation *_animation, const std::s
   return nullptr;
 }
 
-void Mesh::recurseNodeHeirarchy(float _animationTime, const aiNode *_node, const ngl::Mat4 &_parentTransform)
+void Mesh::recurseNodeHeirarchy(float _animationTime, const aiAnimation *_animation, const aiNode *_node,
+                                const ngl::Mat4 &_parentTransform, std::vector<ngl::Mat4> &o_transforms) const
 {
   std::string name(_node->mName.data);
 
-  const aiAnimation *animation = m_scene->mAnimations[m_activeAnimations];
-
   ngl::Mat4 nodeTransform = AIU::aiMatrix4x4ToNGLMat4(_node->mTransformation);
 
-  const aiNodeAnim *nodeAnim = findNodeAnim(animation, name);
+  const aiNodeAnim *nodeAnim = findNodeAnim(_animation, name);
 
   if (nodeAnim)
   {
@@ -245,30 +268,35 @@ void Mesh::recurseNodeHeirarchy(float _animationTime, const aiNode *_node, const
 
   ngl::Mat4 globalTransform = nodeTransform * _parentTransform;
 
-  if (m_boneMapping.find(name) != m_boneMapping.end())
+  auto bone = m_boneMapping.find(name);
+  if (bone != m_boneMapping.end())
   {
-    unsigned int boneIndex = m_boneMapping[name];
-    m_boneInfo[boneIndex].finalTransformation = m_boneInfo[boneIndex].boneOffset *
-                                                globalTransform *
-                                                m_globalInverseTransform;
+    unsigned int boneIndex = bone->second;
+    ngl::Mat4 finalTransformation = m_boneInfo[boneIndex].boneOffset *
+                                    globalTransform *
+                                    m_globalInverseTransform;
+    // now copy this data note that we need to transpose for NGL useage
+    // this data will be copied to the shader and used in the animation skinning
+    // process
+    o_transforms[boneIndex] = finalTransformation.transpose();
   }
 
   for (unsigned int i = 0; i < _node->mNumChildren; ++i)
   {
-    recurseNodeHeirarchy(_animationTime, _node->mChildren[i], globalTransform);
+    recurseNodeHeirarchy(_animationTime, _animation, _node->mChildren[i], globalTransform, o_transforms);
   }
 }
 
-void Mesh::initFromScene(const aiScene *_scene)
+void Mesh::initFromScene(const aiScene *_scene, GeometryData &o_data)
 {
   std::cout << "init from scene\n";
   m_entries.resize(_scene->mNumMeshes);
 
-  std::vector<ngl::Vec3> positions;
-  std::vector<ngl::Vec3> normals;
-  std::vector<ngl::Vec2> texCords;
-  std::vector<VertexBoneData> bones;
-  std::vector<GLuint> indices;
+  ArenaVector<ngl::Vec3> &positions = o_data.positions;
+  ArenaVector<ngl::Vec3> &normals = o_data.normals;
+  ArenaVector<ngl::Vec2> &texCords = o_data.texCoords;
+  ArenaVector<VertexBoneData> &bones = o_data.bones;
+  ArenaVector<unsigned int> &indices = o_data.indices;
 
   unsigned int NumVertices = 0;
   unsigned int NumIndices = 0;
@@ -280,59 +308,81 @@ void Mesh::initFromScene(const aiScene *_scene)
     m_entries[i].NumIndices = _scene->mMeshes[i]->mNumFaces * 3;
     m_entries[i].BaseVertex = NumVertices;
     m_entries[i].BaseIndex = NumIndices;
+    m_entries[i].IndexSize = _scene->mMeshes[i]->mNumVertices <= 65536 ? sizeof(unsigned short) : sizeof(unsigned int);
 
     NumVertices += _scene->mMeshes[i]->mNumVertices;
     NumIndices += m_entries[i].NumIndices;
   }
 
-  // Reserve space in the vectors for the vertex attributes and indices
-  positions.reserve(NumVertices);
-  normals.reserve(NumVertices);
-  texCords.reserve(NumVertices);
+  // Reserve space in the vectors for the vertex attributes and indices, the arena never reuses memory
+  // so growing a vector would waste the old storage. The LODs go on the end of the indices, each
+  // level is at most 3/4 of the one before so the whole chain fits in maxChainIndices
+  o_data.numVertices = NumVertices;
+  if (o_data.vertexStreams)
+  {
+    positions.reserve(NumVertices);
+    normals.reserve(NumVertices);
+    texCords.reserve(NumVertices);
+  }
   bones.resize(NumVertices);
-  indices.reserve(NumIndices);
+  indices.reserve(Simplify::maxChainIndices(NumIndices));
 
   // Initialize the meshes in the scene one by one
   for (unsigned int i = 0; i < size; ++i)
   {
     const aiMesh *paiMesh = _scene->mMeshes[i];
-    initMesh(i, paiMesh, positions, normals, texCords, bones, indices);
+    initMesh(i, paiMesh, positions, normals, texCords, bones, indices, o_data.vertexStreams);
   }
 
-  m_vao->bind();
-  m_vao->setData(MultiBufferIndexVAO::VertexData(positions.size() * sizeof(ngl::Vec3), positions[0].m_x)); //,indices.size(),&indices[0],GL_UNSIGNED_INT,GL_STATIC_DRAW);
-  m_vao->setVertexAttributePointer(0, 3, GL_FLOAT, 0, 0);
-  m_vao->setData(MultiBufferIndexVAO::VertexData(texCords.size() * sizeof(ngl::Vec2), texCords[0].m_x)); //,indices.size(),&indices[0],GL_UNSIGNED_INT,GL_STATIC_DRAW);
-  m_vao->setVertexAttributePointer(1, 2, GL_FLOAT, 0, 0);
-
-  m_vao->setData(MultiBufferIndexVAO::VertexData(normals.size() * sizeof(ngl::Vec3), normals[0].m_x)); //,indices.size(),&indices[0],GL_UNSIGNED_INT,GL_STATIC_DRAW);
-  m_vao->setVertexAttributePointer(2, 3, GL_FLOAT, 0, 0);
-
-  // as we are storing the abstract we need to get the concrete here to call setIndices, do a quick cast
-  auto vao = static_cast<MultiBufferIndexVAO *>(m_vao.get());
-  vao->setIndices(indices.size(), &indices[0], GL_UNSIGNED_INT);
-
-  vao->setData(sizeof(VertexBoneData) * bones.size(), &bones[0], GL_STATIC_DRAW);
-
-  vao->setVertexAttributePointer(3, 4, GL_INT, sizeof(VertexBoneData), 0);
-  m_vao->setVertexAttributePointer(4, 4, GL_FLOAT, sizeof(VertexBoneData), 4);
-  m_vao->setNumIndices(indices.size());
-  m_vao->unbind();
+  // now build the LOD chain for each mesh, we only collapse a vertex onto another with the same
+  // dominant bone so the weights (which live in the shared vertex data) are kept intact
+  ArenaVector<unsigned int> dominantBone(bones.size(), 0, o_data.arena);
+  for (size_t v = 0; v < bones.size(); ++v)
+  {
+    auto heaviest = std::max_element(bones[v].weights.begin(), bones[v].weights.end());
+    dominantBone[v] = bones[v].ids[std::distance(bones[v].weights.begin(), heaviest)];
+  }
+  // these go to Simplify so can't be in the arena, they are reused for every mesh instead
+  std::vector<std::vector<unsigned int>> lods;
+  std::vector<unsigned int> source;
+  for (unsigned int i = 0; i < size; ++i)
+  {
+    MeshEntry &entry = m_entries[i];
+    entry.LODNumIndices[0] = entry.NumIndices;
+    entry.LODBaseIndex[0] = entry.BaseIndex;
+    source.assign(indices.begin() + entry.BaseIndex, indices.begin() + entry.BaseIndex + entry.NumIndices);
+    // the positions are read from the aiMesh as they may not have been copied
+    Simplify::buildLODChain(&_scene->mMeshes[i]->mVertices[0].x,
+                            _scene->mMeshes[i]->mNumVertices,
+                            sizeof(aiVector3D) / sizeof(float),
+                            source,
+                            lods,
+                            &dominantBone[entry.BaseVertex]);
+    entry.NumLODs = static_cast<unsigned int>(lods.size());
+    // the extra levels go on the end of the index buffer
+    for (size_t l = 1; l < lods.size(); ++l)
+    {
+      entry.LODBaseIndex[l] = static_cast<unsigned int>(indices.size());
+      entry.LODNumIndices[l] = static_cast<unsigned int>(lods[l].size());
+      indices.insert(indices.end(), lods[l].begin(), lods[l].end());
+    }
+  }
 }
 
 void Mesh::initMesh(
     unsigned int _meshIndex,
     const aiMesh *_aiMesh,
-    std::vector<ngl::Vec3> &o_positions,
-    std::vector<ngl::Vec3> &o_normals,
-    std::vector<ngl::Vec2> &o_texCoords,
-    std::vector<VertexBoneData> &o_bones,
-    std::vector<unsigned int> &o_indices)
+    ArenaVector<ngl::Vec3> &o_positions,
+    ArenaVector<ngl::Vec3> &o_normals,
+    ArenaVector<ngl::Vec2> &o_texCoords,
+    ArenaVector<VertexBoneData> &o_bones,
+    ArenaVector<unsigned int> &o_indices,
+    bool _vertexStreams)
 {
   ngl::Vec3 Zero3D(0.0f, 0.0f, 0.0f);
 
   // Populate the vertex attribute vectors
-  for (unsigned int i = 0; i < _aiMesh->mNumVertices; ++i)
+  for (unsigned int i = 0; _vertexStreams && i < _aiMesh->mNumVertices; ++i)
   {
     ngl::Vec3 pos = AIU::aiVector3DToNGLVec3(_aiMesh->mVertices[i]);
     ngl::Vec3 normal = AIU::aiVector3DToNGLVec3(_aiMesh->mNormals[i]);
@@ -355,14 +405,16 @@ void Mesh::initMesh(
   }
 }
 
-void Mesh::loadBones(unsigned int _meshIndex, const aiMesh *_mesh, std::vector<VertexBoneData> &o_bones)
+void Mesh::loadBones(unsigned int _meshIndex, const aiMesh *_mesh, ArenaVector<VertexBoneData> &o_bones)
 {
   for (unsigned int i = 0; i < _mesh->mNumBones; ++i)
   {
     unsigned int BoneIndex = 0;
     std::string boneName(_mesh->mBones[i]->mName.data);
 
-    if (m_boneMapping.find(boneName) == m_boneMapping.end())
+    // the mapping is used every frame so it lives with the mesh rather than in the arena
+    auto bone = m_boneMapping.find(boneName);
+    if (bone == m_boneMapping.end())
     {
       // Allocate an index for a new bone
       BoneIndex = m_numBones;
@@ -371,11 +423,11 @@ void Mesh::loadBones(unsigned int _meshIndex, const aiMesh *_mesh, std::vector<V
       m_boneInfo.push_back(bi);
       // this is the Matrix that transforms from mesh space to bone space in bind pose.
       m_boneInfo[BoneIndex].boneOffset = AIU::aiMatrix4x4ToNGLMat4(_mesh->mBones[i]->mOffsetMatrix);
-      m_boneMapping[boneName] = BoneIndex;
+      m_boneMapping.emplace(std::move(boneName), BoneIndex);
     }
     else
     {
-      BoneIndex = m_boneMapping[boneName];
+      BoneIndex = bone->second;
     }
 
     for (unsigned int j = 0; j < _mesh->mBones[i]->mNumWeights; ++j)
@@ -383,6 +435,19 @@ void Mesh::loadBones(unsigned int _meshIndex, const aiMesh *_mesh, std::vector<V
       unsigned int VertexID = m_entries[_meshIndex].BaseVertex + _mesh->mBones[i]->mWeights[j].mVertexId;
       float Weight = _mesh->mBones[i]->mWeights[j].mWeight;
       o_bones[VertexID].addBoneData(BoneIndex, Weight);
+      // grow the bind pose box for this bone, any vertex it moves must be inside it
+      if (Weight > 0.0f)
+      {
+        const aiVector3D &p = _mesh->mVertices[_mesh->mBones[i]->mWeights[j].mVertexId];
+        BoneInfo &info = m_boneInfo[BoneIndex];
+        info.boundsMin.m_x = std::min(info.boundsMin.m_x, p.x);
+        info.boundsMin.m_y = std::min(info.boundsMin.m_y, p.y);
+        info.boundsMin.m_z = std::min(info.boundsMin.m_z, p.z);
+        info.boundsMax.m_x = std::max(info.boundsMax.m_x, p.x);
+        info.boundsMax.m_y = std::max(info.boundsMax.m_y, p.y);
+        info.boundsMax.m_z = std::max(info.boundsMax.m_z, p.z);
+        info.hasBounds = true;
+      }
     }
   }
 }
@@ -395,4 +460,10 @@ void Mesh::setActiveAnimation(int _anim)
 
 void Mesh::clear()
 {
+  // the GL objects are only created by MeshRender.cpp so release them through it, tools that
+  // never upload link this file without any GL
+  if (m_releaseGL != nullptr)
+  {
+    m_releaseGL(*this);
+  }
 }
@@ -0,0 +1,230 @@
+#include "Mesh.h"
+#include <ngl/AbstractVAO.h>
+#include <ngl/VAOFactory.h>
+#include "MultiBufferIndexVAO.h"
+#include "Profiler.h"
+#include "RenderStats.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+/// @brief the GL side of Mesh, everything else (conversion and animation) is in Mesh.cpp and doesn't
+/// need a context
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief write one vertex stream of every mesh in the scene straight into the bound array buffer,
+/// the meshes are packed in order so each one starts at its MeshEntry::BaseVertex. _components
+/// floats are taken from each aiVector3D (2 for the uvs) and missing streams are zeroed
+//----------------------------------------------------------------------------------------------------------------------
+static void mapStream(const aiScene *_scene, size_t _numVertices, size_t _components,
+                      const aiVector3D *(*_stream)(const aiMesh *))
+{
+  auto bytes = static_cast<GLsizeiptr>(_numVertices * _components * sizeof(float));
+  auto dst = static_cast<float *>(glMapBufferRange(GL_ARRAY_BUFFER, 0, bytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+  if (dst == nullptr)
+  {
+    std::cerr << "unable to map vertex buffer\n";
+    return;
+  }
+  for (unsigned int m = 0; m < _scene->mNumMeshes; ++m)
+  {
+    const aiMesh *mesh = _scene->mMeshes[m];
+    const aiVector3D *src = _stream(mesh);
+    size_t count = mesh->mNumVertices;
+    if (src == nullptr)
+    {
+      std::fill(dst, dst + count * _components, 0.0f);
+    }
+    else if (_components == 3)
+    {
+      std::memcpy(dst, src, count * sizeof(aiVector3D));
+    }
+    else
+    {
+      for (size_t v = 0; v < count; ++v)
+      {
+        dst[v * 2] = src[v].x;
+        dst[v * 2 + 1] = src[v].y;
+      }
+    }
+    dst += count * _components;
+  }
+  glUnmapBuffer(GL_ARRAY_BUFFER);
+}
+
+bool Mesh::load(const aiScene *_scene, bool _verbose)
+{
+  GeometryData data;
+  // the vertex streams are uploaded from the scene in createVAO
+  data.vertexStreams = false;
+  bool success = loadData(_scene, data);
+  if (success)
+  {
+    // we have already forced the load to be trinagles so no need to check
+    m_vao = ngl::VAOFactory::createVAO("multiBufferIndexVAO", GL_TRIANGLES);
+    createVAO(data);
+    if (_verbose)
+    {
+      for (auto &entry : m_entries)
+      {
+        std::cout << "mesh entry " << entry.IndexSize * 8 << " bit LODs " << entry.NumLODs << " indices ";
+        for (size_t l = 0; l < entry.NumLODs; ++l)
+        {
+          std::cout << entry.LODNumIndices[l] << ' ';
+        }
+        std::cout << '\n';
+      }
+      auto &stats = data.arena.stats();
+      std::cout << "load scratch " << stats.allocations << " allocations " << stats.bytes / 1024 << " KB from "
+                << stats.blocks << " heap blocks\n";
+    }
+  }
+  // the scratch all goes here in one go now it has been uploaded
+  return success;
+}
+
+void Mesh::createVAO(GeometryData &io_data)
+{
+  m_vao->bind();
+  // as we are storing the abstract we need to get the concrete here to call setIndices, do a quick cast
+  auto vao = static_cast<MultiBufferIndexVAO *>(m_vao.get());
+  // each buffer is sized for the whole scene then filled from the aiMesh arrays, the positions and
+  // normals are already packed floats and the uvs go from 3 to 2 floats on the way
+  size_t numVertices = io_data.numVertices;
+  vao->setData(numVertices * sizeof(ngl::Vec3), nullptr, GL_STATIC_DRAW);
+  mapStream(m_scene, numVertices, 3, [](const aiMesh *_mesh) -> const aiVector3D * { return _mesh->mVertices; });
+  m_vao->setVertexAttributePointer(0, 3, GL_FLOAT, 0, 0);
+  vao->setData(numVertices * sizeof(ngl::Vec2), nullptr, GL_STATIC_DRAW);
+  mapStream(m_scene, numVertices, 2, [](const aiMesh *_mesh) -> const aiVector3D *
+            { return _mesh->HasTextureCoords(0) ? _mesh->mTextureCoords[0] : nullptr; });
+  m_vao->setVertexAttributePointer(1, 2, GL_FLOAT, 0, 0);
+
+  vao->setData(numVertices * sizeof(ngl::Vec3), nullptr, GL_STATIC_DRAW);
+  mapStream(m_scene, numVertices, 3, [](const aiMesh *_mesh) -> const aiVector3D * { return _mesh->mNormals; });
+  m_vao->setVertexAttributePointer(2, 3, GL_FLOAT, 0, 0);
+
+  // the entries are packed one after another each at its own index width (32 bit ones aligned to 4
+  // bytes) so the buffer is raw bytes, render passes the type and offset of each entry to the draw
+  size_t indexBytes = 0;
+  for (auto &entry : m_entries)
+  {
+    for (size_t l = 0; l < entry.NumLODs; ++l)
+    {
+      indexBytes = (indexBytes + entry.IndexSize - 1) / entry.IndexSize * entry.IndexSize;
+      entry.LODIndexOffset[l] = indexBytes;
+      indexBytes += entry.LODNumIndices[l] * entry.IndexSize;
+    }
+  }
+  ArenaVector<unsigned char> packed(indexBytes, 0, io_data.arena);
+  for (auto &entry : m_entries)
+  {
+    for (size_t l = 0; l < entry.NumLODs; ++l)
+    {
+      const unsigned int *src = &io_data.indices[entry.LODBaseIndex[l]];
+      unsigned char *dst = &packed[entry.LODIndexOffset[l]];
+      if (entry.IndexSize == sizeof(GLushort))
+      {
+        for (size_t i = 0; i < entry.LODNumIndices[l]; ++i)
+        {
+          auto index = static_cast<GLushort>(src[i]);
+          std::memcpy(dst + i * sizeof(GLushort), &index, sizeof(GLushort));
+        }
+      }
+      else
+      {
+        std::memcpy(dst, src, entry.LODNumIndices[l] * sizeof(GLuint));
+      }
+    }
+  }
+  vao->setIndexBuffer(indexBytes, packed.data());
+
+  vao->setData(sizeof(VertexBoneData) * io_data.bones.size(), &io_data.bones[0], GL_STATIC_DRAW);
+
+  vao->setVertexAttributePointer(3, 4, GL_INT, sizeof(VertexBoneData), 0);
+  m_vao->setVertexAttributePointer(4, 4, GL_FLOAT, sizeof(VertexBoneData), 4);
+  // per instance model matrix, a mat4 takes 4 attribute slots (5-8) and only steps once per
+  // instance. We start with a single identity instance until setInstanceTransforms is called
+  ngl::Mat4 identity(1.0f);
+  glGenBuffers(1, &m_instanceBuffer);
+  m_releaseGL = &Mesh::releaseGL;
+  glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(ngl::Mat4), &identity.m_00, GL_STREAM_DRAW);
+  for (GLuint c = 0; c < 4; ++c)
+  {
+    m_vao->setVertexAttributePointer(5 + c, 4, GL_FLOAT, sizeof(ngl::Mat4), c * 4);
+    glVertexAttribDivisor(5 + c, 1);
+  }
+  m_vao->unbind();
+}
+
+void Mesh::releaseGL(Mesh &io_mesh)
+{
+  if (io_mesh.m_instanceBuffer != 0)
+  {
+    glDeleteBuffers(1, &io_mesh.m_instanceBuffer);
+    io_mesh.m_instanceBuffer = 0;
+  }
+  if (io_mesh.m_vao)
+  {
+    io_mesh.m_vao->removeVAO();
+    io_mesh.m_vao.reset();
+  }
+  io_mesh.m_releaseGL = nullptr;
+}
+
+void Mesh::render(size_t _lod, size_t _firstInstance, size_t _numInstances) const
+{
+  m_vao->bind();
+  RenderStats::addVAOBind();
+  // start the instance matrices at this range, they only step once per instance so every draw
+  // below reads the same ones
+  glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+  for (GLuint c = 0; c < 4; ++c)
+  {
+    glVertexAttribPointer(5 + c, 4, GL_FLOAT, GL_FALSE, sizeof(ngl::Mat4),
+                          reinterpret_cast<GLvoid *>(_firstInstance * sizeof(ngl::Mat4) + c * 4 * sizeof(GLfloat)));
+  }
+  /// unsigned int size=m_entries.size();
+  // for (unsigned int i = 0 ; i < size; ++i)
+  for (auto &entry : m_entries)
+  {
+    // whist we have the data stored in our VAO structure we only need to bind to re-activate the
+    // attribute data, then we draw using ElemetsBaseVertex. This is similar to how the
+    // sponza demo works, really if you were dealing with different model textures etc this would
+    // also be switched here for each of the different mesh entries.
+    // The LOD levels are just different ranges of the same index buffer.
+    size_t lod = std::min<size_t>(_lod, entry.NumLODs - 1);
+    PROFILE_GPU("drawEntry");
+    // every instance is drawn in the one call, the shader uses gl_InstanceID to find the palette
+    glDrawElementsInstancedBaseVertex(GL_TRIANGLES,
+                                      entry.LODNumIndices[lod],
+                                      entry.IndexSize == sizeof(GLushort) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT,
+                                      (void *)(entry.LODIndexOffset[lod]),
+                                      static_cast<GLsizei>(_numInstances),
+                                      entry.BaseVertex);
+    RenderStats::addDraw(entry.LODNumIndices[lod], _numInstances);
+
+    // seems that BaseVertex isn't under linux (not sure why) this works as well but doesn't
+    // cope with embedded meshes so well
+    //  glDrawElements(GL_TRIANGLES,
+    //                           m_entries[i].NumIndices,
+    //                           GL_UNSIGNED_INT,
+    //                           (void*)(sizeof(unsigned int) * m_entries[i].BaseIndex)
+    //                           );
+  }
+  m_vao->unbind();
+}
+
+void Mesh::setInstanceTransforms(const std::vector<ngl::Mat4> &_transforms)
+{
+  if (_transforms.empty())
+  {
+    return;
+  }
+  glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+  auto bytes = static_cast<GLsizeiptr>(_transforms.size() * sizeof(ngl::Mat4));
+  glBufferData(GL_ARRAY_BUFFER, bytes, nullptr, GL_STREAM_DRAW);
+  glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, &_transforms[0].m_00);
+  RenderStats::addBufferBytes(static_cast<size_t>(bytes));
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
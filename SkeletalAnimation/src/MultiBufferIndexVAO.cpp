@@ -1,4 +1,5 @@
 #include "MultiBufferIndexVAO.h"
+#include "RenderStats.h"
 #include <iostream>
 
 void MultiBufferIndexVAO::draw() const
@@ -11,7 +12,13 @@ void MultiBufferIndexVAO::draw() const
   {
     std::cerr<<"Warning trying to draw an unbound VOA\n";
   }
+  if(m_indexType == GL_NONE)
+  {
+    std::cerr<<"Warning the index buffer has mixed types, draw each range with its own type\n";
+    return;
+  }
   glDrawElements(m_mode,static_cast<GLsizei>(m_indicesCount),m_indexType,static_cast<ngl::Real *>(nullptr));
+  RenderStats::addDraw(m_indicesCount);
 }
 
 
@@ -25,7 +32,13 @@ void MultiBufferIndexVAO::draw(int _startIndex, int _amount) const
   {
     std::cerr<<"Warning trying to draw an unbound VOA\n";
   }
+  if(m_indexType == GL_NONE)
+  {
+    std::cerr<<"Warning the index buffer has mixed types, draw each range with its own type\n";
+    return;
+  }
 
+  RenderStats::addDraw(static_cast<size_t>(_amount));
   switch(m_indexType)
   {
     case GL_UNSIGNED_INT   :
@@ -72,7 +85,8 @@ void MultiBufferIndexVAO::setData(size_t _size, const GLvoid *_data, GLenum _mod
   // now we will bind an array buffer to the first one and load the data for the verts
   glBindBuffer(GL_ARRAY_BUFFER, vboID);
   glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(_size), _data, _mode);
-
+  RenderStats::addBufferBytes(_size);
+  m_allocated=true;
 }
 
 void MultiBufferIndexVAO::setVertexAttributePointer( GLuint _id,  GLint _size, GLenum _type, GLsizei _stride, unsigned int _dataOffset )
@@ -99,6 +113,7 @@ void MultiBufferIndexVAO::setData(const VertexData &_data)
   // now we will bind an array buffer to the first one and load the data for the verts
   glBindBuffer(GL_ARRAY_BUFFER, vboID);
   glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(_data.m_size), &_data.m_data, _data.m_mode);
+  RenderStats::addBufferBytes(_data.m_size);
 
   m_allocated=true;
 }
@@ -119,9 +134,22 @@ void MultiBufferIndexVAO::setIndices(unsigned int _indexSize,const GLvoid *_inde
   // now for the indices
   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, iboID);
   glBufferData(GL_ELEMENT_ARRAY_BUFFER, _indexSize * static_cast<GLsizeiptr>(size), const_cast<GLvoid *>(_indexData), _mode);
+  RenderStats::addBufferBytes(_indexSize * static_cast<size_t>(size));
   m_indexType=_indexType;
 }
 
+void MultiBufferIndexVAO::setIndexBuffer(size_t _bytes,const GLvoid *_data,GLenum _mode)
+{
+  GLuint iboID;
+  glGenBuffers(1, &iboID);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, iboID);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(_bytes), _data, _mode);
+  RenderStats::addBufferBytes(_bytes);
+  // there is no single type or count so draw() is disabled
+  m_indexType=GL_NONE;
+  m_indicesCount=0;
+}
+
 ngl::Real *MultiBufferIndexVAO::mapBuffer(unsigned int _index, GLenum _accessMode)
 {
   ngl::Real *ptr=nullptr;
@@ -3,6 +3,8 @@
 
 #include "NGLScene.h"
 #include "AIUtil.h"
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <ngl/NGLInit.h>
 #include <ngl/NGLStream.h>
@@ -12,20 +14,44 @@
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 #include <assimp/vector3.h>
-#include <QTime>
 #include "MultiBufferIndexVAO.h"
+#include "Profiler.h"
+#include "ShaderCache.h"
+#include "UniformBinding.h"
+#include "RenderStats.h"
 
-NGLScene::NGLScene(const char *_fname)
+NGLScene::NGLScene(const char *_fname, size_t _crowdSize, unsigned int _importFlags, bool _timeImport,
+                   std::shared_ptr<AssetArchive> _archive, unsigned int _poseLatency)
+    : m_assets(std::move(_archive)), m_poses(_poseLatency)
 {
   setTitle("Using libassimp with NGL for Animation");
+  m_crowdSize = _crowdSize;
   m_animate = true;
   m_frameTime = 0.0f;
   m_sceneName = _fname;
+  m_importFlags = _importFlags;
+  m_timeImport = _timeImport;
+  m_scheduler.setAnimating(m_animate);
+  // the swap happens after paintGL returns so the frame is closed when Qt tells us it is done, while
+  // animating the next frame is asked for here so we draw once per vsync and not at all when idle
+  connect(this, &QOpenGLWindow::frameSwapped, [this]()
+  {
+    PROFILE_END_FRAME();
+    if (m_scheduler.wantsFrame())
+    {
+      update();
+    }
+  });
 }
 
 NGLScene::~NGLScene()
 {
+  // the GL members are released after this body runs so make sure their context is current, in
+  // headless mode the window never made one and the renderer's context stays current instead
+  makeCurrent();
   std::cout << "Shutting down NGL, removing VAO's and Shaders\n";
+  printFrameStats();
+  PROFILE_WRITE_TRACE("profile.json");
 }
 
 void NGLScene::resizeGL(int _w, int _h)
@@ -34,6 +60,14 @@ void NGLScene::resizeGL(int _w, int _h)
   m_win.width = static_cast<int>(_w * devicePixelRatio());
   m_win.height = static_cast<int>(_h * devicePixelRatio());
 }
+void NGLScene::setFixedFrame(size_t _frame, size_t _numFrames)
+{
+  m_animate = false;
+  m_scheduler.setAnimating(false);
+  m_frameTime = static_cast<float>(_frame) / 60.0f;
+  m_win.spinYFace = static_cast<int>((360 * _frame) / std::max<size_t>(_numFrames, 1));
+}
+
 void NGLScene::initializeGL()
 {
   // we must call this first before any other GL commands to load and link the
@@ -48,54 +82,42 @@ void NGLScene::initializeGL()
   glEnable(GL_DEPTH_TEST);
   // enable multisampling for smoother drawing
   glEnable(GL_MULTISAMPLE);
-  m_scene = m_importer.ReadFile(m_sceneName,
-                                aiProcessPreset_TargetRealtime_Quality |
-                                    aiProcess_Triangulate);
-  if (m_scene == nullptr)
+  m_mesh = m_assets.load(m_sceneName, m_importFlags, m_timeImport);
+  if (!m_mesh)
   {
     std::cerr << "Error loading scene file\n";
     exit(EXIT_FAILURE);
   }
-  std::cout << "num animations " << m_scene->mNumAnimations << "\n";
-  m_numAnimations = m_scene->mNumAnimations;
-  if (m_scene->mNumAnimations < 1)
+  std::cout << "num animations " << m_mesh->numAnimations() << "\n";
+  m_numAnimations = m_mesh->numAnimations();
+  if (m_numAnimations < 1)
   {
     std::cerr << "No animations in this scene exiting\n";
     exit(EXIT_FAILURE);
   }
-  bool loaded = m_mesh.load(m_scene);
-  if (loaded == false)
-  {
-    std::cerr << "Assimp reports " << m_importer.GetErrorString() << "\n";
-    exit(EXIT_FAILURE);
-  }
   // now to load the shader and set the values
   // we are creating a shader called Skinning use string to avoid typos
   auto constexpr Skinning = "Skinning";
-  auto constexpr SkinningVertex = "SkinningVertex";
-  auto constexpr SkinningFragment = "SkinningFragment";
-
-  ngl::ShaderLib::createShaderProgram(Skinning);
-  // now we are going to create empty shaders for Frag and Vert
-  ngl::ShaderLib::attachShader(SkinningVertex, ngl::ShaderType::VERTEX);
-  ngl::ShaderLib::attachShader(SkinningFragment, ngl::ShaderType::FRAGMENT);
-  // attach the source
-  ngl::ShaderLib::loadShaderSource(SkinningVertex, "shaders/SkinningVertex.glsl");
-  ngl::ShaderLib::loadShaderSource(SkinningFragment, "shaders/SkinningFragment.glsl");
-  // compile the shaders
-  ngl::ShaderLib::compileShader(SkinningVertex);
-  ngl::ShaderLib::compileShader(SkinningFragment);
-  // add them to the program
-  ngl::ShaderLib::attachShaderToProgram(Skinning, SkinningVertex);
-  ngl::ShaderLib::attachShaderToProgram(Skinning, SkinningFragment);
-  // now bind the shader attributes for most NGL primitives we use the following
-  // now we have associated this data we can link the shader
-  ngl::ShaderLib::linkProgramObject(Skinning);
+  // build the program (SkinningVertex / SkinningFragment) from the binary cache or from source
+  ShaderCache::loadProgram(Skinning, "shaders/SkinningVertex.glsl", "shaders/SkinningFragment.glsl");
   ngl::ShaderLib::printRegisteredUniforms(Skinning);
   ngl::ShaderLib::use(Skinning);
 
+  // frame the camera on the posed mesh at the start of the clip, the bind pose box from the
+  // scene can be a long way from where the animation actually puts the character
+  std::vector<ngl::Mat4> transforms;
+  m_mesh->boneTransform(0.0f, transforms);
   ngl::Vec3 min, max;
-  AIU::getSceneBoundingBox(m_scene, min, max);
+  m_mesh->getAnimatedBounds(transforms, min, max);
+  // lay out the crowd and grow the box so the camera sees all of it
+  ngl::Vec3 size = max - min;
+  float spacing = std::max(size.m_x, size.m_z) * 1.5f;
+  buildCrowd(spacing);
+  float gridExtent = (std::ceil(std::sqrt(static_cast<float>(m_crowdSize))) - 1.0f) * spacing * 0.5f;
+  min.m_x -= gridExtent;
+  min.m_z -= gridExtent;
+  max.m_x += gridExtent;
+  max.m_z += gridExtent;
   ngl::Vec3 center = (min + max) / 2.0f;
   ngl::Vec3 from;
   from.m_x = 0;
@@ -108,45 +130,147 @@ void NGLScene::initializeGL()
   // The final two are near and far clipping planes of 0.5 and 10
   m_project = ngl::perspective(45.0f, 720.0f / 576.0f, 0.05f, 350.0f);
 
+  // the camera and light go in the shared uniform block, the matrices are filled in each frame
+  GLuint program = ngl::ShaderLib::getProgramID(Skinning);
+  m_frameUniforms = std::make_unique<FrameUniforms>();
+  m_frameUniforms->attach(program);
+  FrameUniforms::Block &frame = m_frameUniforms->data();
   ngl::Vec4 lightPos = from;
   ngl::Mat4 iv = m_view;
   iv.inverse().transpose();
-  ngl::ShaderLib::setUniform("light.position", lightPos * iv);
-  ngl::ShaderLib::setUniform("light.ambient", 0.1f, 0.1f, 0.1f, 1.0f);
-  ngl::ShaderLib::setUniform("light.diffuse", 1.0f, 1.0f, 1.0f, 1.0f);
-  ngl::ShaderLib::setUniform("light.specular", 0.8f, 0.8f, 0.8f, 1.0f);
-  // gold like phong material
-  ngl::ShaderLib::setUniform("material.ambient", 0.274725f, 0.1995f, 0.0745f, 0.0f);
-  ngl::ShaderLib::setUniform("material.diffuse", 0.75164f, 0.60648f, 0.22648f, 0.0f);
-  ngl::ShaderLib::setUniform("material.specular", 0.628281f, 0.555802f, 0.3666065f, 0.0f);
-  ngl::ShaderLib::setUniform("material.shininess", 51.2f);
-  ngl::ShaderLib::setUniform("viewerPos", from);
-
-  // now create our light this is done after the camera so we can pass the
-  // transpose of the projection matrix to the light to do correct eye space
-  // transformations
-  startTimer(20);
+  frame.lightPosition = lightPos * iv;
+  frame.lightAmbient = ngl::Vec4(0.1f, 0.1f, 0.1f, 1.0f);
+  frame.lightDiffuse = ngl::Vec4(1.0f, 1.0f, 1.0f, 1.0f);
+  frame.lightSpecular = ngl::Vec4(0.8f, 0.8f, 0.8f, 1.0f);
+  frame.viewerPos = ngl::Vec4(from, 1.0f);
+  // gold like phong material, this never changes so is set once
+  UniformLocation(program, "material.ambient").set(ngl::Vec4(0.274725f, 0.1995f, 0.0745f, 0.0f));
+  UniformLocation(program, "material.diffuse").set(ngl::Vec4(0.75164f, 0.60648f, 0.22648f, 0.0f));
+  UniformLocation(program, "material.specular").set(ngl::Vec4(0.628281f, 0.555802f, 0.3666065f, 0.0f));
+  UniformLocation(program, "material.shininess").set(51.2f);
+  // the palettes live in a texture buffer on unit 0
+  m_palette = std::make_unique<BonePaletteBuffer>();
+  UniformLocation(program, "gBonePalette").set(0);
+  UniformLocation(program, "numBones").set(static_cast<int>(m_mesh->numBones()));
+  m_instanceBase = UniformLocation(program, "instanceBase");
+  m_instanceBase.set(0);
+
+}
+
+void NGLScene::buildCrowd(float _spacing)
+{
+  size_t side = static_cast<size_t>(std::ceil(std::sqrt(static_cast<float>(m_crowdSize))));
+  float offset = (side - 1) * _spacing * 0.5f;
+  float duration = static_cast<float>(m_mesh->getDuration() / m_mesh->getTicksPerSec());
+  m_crowd.resize(m_crowdSize);
+  for (size_t i = 0; i < m_crowdSize; ++i)
+  {
+    Character &c = m_crowd[i];
+    // every character asks for the model, the manager hands back the one already loaded
+    c.mesh = m_assets.load(m_sceneName, m_importFlags);
+    // step through the clip by the golden ratio so neighbours are never in step
+    float phase = static_cast<float>(i) * 0.618034f;
+    c.timeOffset = (phase - std::floor(phase)) * duration;
+    c.clip = static_cast<unsigned int>(m_activeAnimation);
+    c.transform = ngl::Mat4::translate((i % side) * _spacing - offset, 0.0f, (i / side) * _spacing - offset);
+  }
+  std::cout << "crowd of " << m_crowdSize << " characters using " << m_assets.liveAssets() << " loaded model(s), "
+            << m_assets.hits() << " cache hits " << m_assets.misses() << " loads\n";
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief test a box against the view frustum, each corner is taken to clip space and the box is
+/// rejected if all 8 corners are outside the same plane
+//----------------------------------------------------------------------------------------------------------------------
+static bool isBoxVisible(const ngl::Mat4 &_MVP, const ngl::Vec3 &_min, const ngl::Vec3 &_max)
+{
+  // one bit per frustum plane, a bit stays set only if every corner is outside that plane
+  unsigned int outside = 0x3f;
+  for (int i = 0; i < 8; ++i)
+  {
+    float p[3] = {(i & 1) ? _max.m_x : _min.m_x,
+                  (i & 2) ? _max.m_y : _min.m_y,
+                  (i & 4) ? _max.m_z : _min.m_z};
+    float clip[4];
+    for (int r = 0; r < 4; ++r)
+    {
+      clip[r] = _MVP.m_m[0][r] * p[0] + _MVP.m_m[1][r] * p[1] + _MVP.m_m[2][r] * p[2] + _MVP.m_m[3][r];
+    }
+    unsigned int corner = 0;
+    corner |= (clip[0] < -clip[3]) ? 0x01 : 0;
+    corner |= (clip[0] > clip[3]) ? 0x02 : 0;
+    corner |= (clip[1] < -clip[3]) ? 0x04 : 0;
+    corner |= (clip[1] > clip[3]) ? 0x08 : 0;
+    corner |= (clip[2] < -clip[3]) ? 0x10 : 0;
+    corner |= (clip[2] > clip[3]) ? 0x20 : 0;
+    outside &= corner;
+  }
+  return outside == 0;
 }
 
 void NGLScene::loadMatricesToShader()
 {
-  ngl::Mat4 MV;
-  ngl::Mat4 MVP;
-  ngl::Mat4 M;
-  M = m_mouseGlobalTX * m_transform.getMatrix();
-  MV = m_view * M;
-  MVP = m_project * MV;
-  ngl::ShaderLib::setUniform("MV", MV);
-  ngl::ShaderLib::setUniform("MVP", MVP);
-  ngl::ShaderLib::setUniform("M", M);
+  // one buffer update for the whole frame rather than a uniform call (and name lookup) per matrix
+  FrameUniforms::Block &frame = m_frameUniforms->data();
+  frame.M = m_mouseGlobalTX * m_transform.getMatrix();
+  frame.MV = m_view * frame.M;
+  frame.MVP = m_project * frame.MV;
+  frame.normalMatrix = frame.MV;
+  frame.normalMatrix.inverse().transpose();
+  m_frameUniforms->upload();
+}
+
+void NGLScene::submitPoses(float _time)
+{
+  // m_poseJobs holds the last collected batch so its palettes are reused rather than reallocated
+  size_t numJobs = 0;
+  for (size_t i = 0; i < m_crowd.size(); ++i)
+  {
+    Character &c = m_crowd[i];
+    float poseTime = _time + c.timeOffset;
+    if (c.clip == c.poseClip && poseTime == c.poseTime)
+    {
+      continue;
+    }
+    if (numJobs == m_poseJobs.size())
+    {
+      m_poseJobs.emplace_back();
+    }
+    PosePipeline::Job &job = m_poseJobs[numJobs++];
+    job.mesh = c.mesh.get();
+    job.clip = c.clip;
+    job.time = poseTime;
+    job.id = i;
+    c.poseClip = c.clip;
+    c.poseTime = poseTime;
+  }
+  m_poseJobs.resize(numJobs);
+  m_poses.submit(m_poseJobs);
+}
+
+bool NGLScene::collectPoses()
+{
+  m_poses.collect(m_poseJobs);
+  for (auto &job : m_poseJobs)
+  {
+    // swap rather than copy, the job gets the old palette to write into next time
+    Character &c = m_crowd[job.id];
+    c.palette.swap(job.palette);
+    c.boundsMin = job.boundsMin;
+    c.boundsMax = job.boundsMax;
+  }
+  return !m_poseJobs.empty();
 }
 
 void NGLScene::paintGL()
 {
+  PROFILE_BEGIN_FRAME();
+  RenderStats::beginFrame();
   glViewport(0, 0, m_win.width, m_win.height);
   // clear the screen and depth buffer
   glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
   ngl::ShaderLib::use("Skinning");
+  RenderStats::addProgramSwitch();
 
   // Rotation based on the mouse position for our global transform
   ngl::Transformation trans;
@@ -158,28 +282,142 @@ void NGLScene::paintGL()
   m_mouseGlobalTX.m_m[3][0] = m_modelPos.m_x;
   m_mouseGlobalTX.m_m[3][1] = m_modelPos.m_y;
   m_mouseGlobalTX.m_m[3][2] = m_modelPos.m_z;
-  // set this in the TX stack
-  loadMatricesToShader();
-  std::vector<ngl::Mat4> transforms;
+  // the animation clock only moves in whole steps so on a fast display some frames reuse the last poses
+  m_scheduler.beginFrame();
+  float time = m_frameTime;
   if (m_animate)
   {
-    QTime t = QTime::currentTime();
-    float time = float(t.msec()) / 1000.0f * float(m_mesh.getDuration() / m_mesh.getTicksPerSec());
-    m_mesh.boneTransform(time, transforms);
+    time = static_cast<float>(m_scheduler.time());
+    // keep the time so pausing holds this pose
+    m_frameTime = time;
   }
-  else
+  ngl::Mat4 M = m_mouseGlobalTX * m_transform.getMatrix();
+  ngl::Mat4 MV = m_view * M;
+  ngl::Mat4 MVP = m_project * MV;
+  // evaluate each character whose clip or time has changed. Pipelined we draw with the poses asked for
+  // last frame and the worker evaluates this frame's while we draw, otherwise we wait for them here
+  bool posesChanged = false;
   {
-    m_mesh.boneTransform(m_frameTime, transforms);
+    PROFILE_CPU("evaluatePalettes");
+    if (m_poses.latency() > 0)
+    {
+      posesChanged = collectPoses();
+    }
+    submitPoses(time);
+    if (m_poses.latency() == 0 || !m_posesPrimed)
+    {
+      posesChanged |= collectPoses();
+      m_posesPrimed = true;
+    }
   }
-
-  auto size = transforms.size();
-  for (unsigned int i = 0; i < size; ++i)
+  // cull each character using the bounds of its current pose (cheap as it only depends on the bone count)
+  // and note which ones survive
+  m_nextVisible.clear();
+  m_cullLODs.clear();
   {
-    std::string name = fmt::format("gBones[{0}]", i);
-    ngl::ShaderLib::setUniform(name, transforms[i]);
+    PROFILE_CPU("cull");
+    for (size_t i = 0; i < m_crowd.size(); ++i)
+    {
+      const Character &c = m_crowd[i];
+      // the crowd is only translated so we can just move the box
+      ngl::Vec3 offset(c.transform.m_m[3][0], c.transform.m_m[3][1], c.transform.m_m[3][2]);
+      ngl::Vec3 boundsMin = c.boundsMin + offset;
+      ngl::Vec3 boundsMax = c.boundsMax + offset;
+      if (!isBoxVisible(MVP, boundsMin, boundsMax))
+      {
+        continue;
+      }
+      // each character gets the LOD for its own size on screen
+      ngl::Vec3 centre = (boundsMin + boundsMax) * 0.5f;
+      float radius = (boundsMax - boundsMin).length() * 0.5f;
+      size_t lod = Simplify::selectLOD(Simplify::projectedSize(MV, m_project, centre, radius), Simplify::s_maxLODs);
+      m_nextVisible.push_back(i);
+      m_cullLODs.push_back(static_cast<unsigned int>(lod));
+    }
+    // a counting sort makes the characters at each LOD a contiguous run of the palettes, so the
+    // crowd is one instanced draw per LOD
+    std::array<size_t, Simplify::s_maxLODs> next;
+    m_lodCounts.fill(0);
+    for (auto lod : m_cullLODs)
+    {
+      ++m_lodCounts[lod];
+    }
+    size_t first = 0;
+    for (size_t lod = 0; lod < Simplify::s_maxLODs; ++lod)
+    {
+      next[lod] = first;
+      first += m_lodCounts[lod];
+    }
+    m_sortedVisible.resize(m_nextVisible.size());
+    for (size_t v = 0; v < m_nextVisible.size(); ++v)
+    {
+      m_sortedVisible[next[m_cullLODs[v]]++] = m_nextVisible[v];
+    }
+    m_nextVisible.swap(m_sortedVisible);
+    // the palette texture can only address so many characters, drop the rest rather than have the
+    // shader read past the end of the buffer. They are sorted by LOD so the smallest on screen go first
+    size_t maxVisible = m_palette->capacity() / std::max(m_mesh->numBones(), 1u);
+    if (m_nextVisible.size() > maxVisible)
+    {
+      if (!m_warnedCrowdLimit)
+      {
+        std::cerr << "only " << maxVisible << " of " << m_nextVisible.size()
+                  << " visible characters fit in GL_MAX_TEXTURE_BUFFER_SIZE, the rest are not drawn\n";
+        m_warnedCrowdLimit = true;
+      }
+      m_nextVisible.resize(maxVisible);
+      for (auto &count : m_lodCounts)
+      {
+        count = std::min(count, maxVisible);
+        maxVisible -= count;
+      }
+    }
   }
-
-  m_mesh.render();
+  // only repack and upload the palettes when something would be different on the GPU
+  bool visibleChanged = m_nextVisible != m_visible;
+  if (posesChanged || visibleChanged)
+  {
+    PROFILE_CPU("packPalettes");
+    m_visible.swap(m_nextVisible);
+    m_visiblePalettes.clear();
+    m_visibleTransforms.clear();
+    for (auto i : m_visible)
+    {
+      m_visiblePalettes.insert(m_visiblePalettes.end(), m_crowd[i].palette.begin(), m_crowd[i].palette.end());
+      m_visibleTransforms.push_back(m_crowd[i].transform);
+    }
+  }
+  if (!m_visibleTransforms.empty())
+  {
+    {
+      PROFILE_CPU("uploadUniforms");
+      // set this in the TX stack
+      loadMatricesToShader();
+      if (posesChanged || visibleChanged)
+      {
+        m_palette->upload(m_visiblePalettes);
+      }
+      if (visibleChanged)
+      {
+        m_mesh->setInstanceTransforms(m_visibleTransforms);
+      }
+      m_palette->bind(0);
+    }
+    PROFILE_CPU("draw");
+    size_t first = 0;
+    for (size_t lod = 0; lod < Simplify::s_maxLODs; ++lod)
+    {
+      if (m_lodCounts[lod] == 0)
+      {
+        continue;
+      }
+      m_instanceBase.set(static_cast<int>(first));
+      m_mesh->render(lod, first, m_lodCounts[lod]);
+      first += m_lodCounts[lod];
+    }
+  }
+  RenderStats::endFrame();
+  PROFILE_BEGIN_SWAP();
 }
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -213,13 +451,34 @@ void NGLScene::keyPressEvent(QKeyEvent *_event)
   case Qt::Key_Left:
     --m_activeAnimation;
     m_activeAnimation = std::clamp(m_activeAnimation, size_t(0), m_numAnimations - 1);
-    m_mesh.setActiveAnimation(m_activeAnimation);
+    // the clip belongs to each character not the shared mesh
+    for (auto &c : m_crowd)
+    {
+      c.clip = static_cast<unsigned int>(m_activeAnimation);
+    }
 
+    break;
+  // dump the last few seconds of profile data
+  case Qt::Key_P:
+    PROFILE_WRITE_TRACE("profile.json");
+    break;
+  // pause and resume, while paused nothing is redrawn unless the view changes
+  case Qt::Key_Space:
+    m_animate = !m_animate;
+    m_scheduler.setAnimating(m_animate);
+    break;
+  // how evenly the frames are arriving
+  case Qt::Key_J:
+    printFrameStats();
     break;
   case Qt::Key_Right:
     ++m_activeAnimation;
     m_activeAnimation = std::clamp(m_activeAnimation, size_t(0), m_numAnimations - 1);
-    m_mesh.setActiveAnimation(m_activeAnimation);
+    // the clip belongs to each character not the shared mesh
+    for (auto &c : m_crowd)
+    {
+      c.clip = static_cast<unsigned int>(m_activeAnimation);
+    }
     break;
 
   default:
@@ -228,7 +487,13 @@ void NGLScene::keyPressEvent(QKeyEvent *_event)
   update();
 }
 
-void NGLScene::timerEvent(QTimerEvent *)
+void NGLScene::printFrameStats() const
 {
-  update();
+  auto s = m_scheduler.stats();
+  if (s.frames == 0)
+  {
+    return;
+  }
+  std::cout << "frame interval over " << s.frames << " frames : mean " << s.mean << " ms jitter " << s.jitter
+            << " ms min " << s.min << " ms max " << s.max << " ms\n";
 }
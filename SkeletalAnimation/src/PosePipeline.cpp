@@ -0,0 +1,87 @@
+#include "PosePipeline.h"
+#include "Mesh.h"
+#include <cassert>
+
+PosePipeline::PosePipeline(unsigned int _latency) : m_latency(_latency > 0 ? 1 : 0)
+{
+  if (m_latency > 0)
+  {
+    m_worker = std::thread(&PosePipeline::workerLoop, this);
+  }
+}
+
+PosePipeline::~PosePipeline()
+{
+  if (m_worker.joinable())
+  {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_stop = true;
+    }
+    m_wake.notify_one();
+    m_worker.join();
+  }
+}
+
+void PosePipeline::evaluate(Job &io_job)
+{
+  io_job.mesh->evaluatePose(io_job.time, io_job.clip, io_job.palette);
+  io_job.mesh->getAnimatedBounds(io_job.palette, io_job.boundsMin, io_job.boundsMax);
+}
+
+void PosePipeline::submit(std::vector<Job> &io_jobs)
+{
+  if (m_latency == 0)
+  {
+    for (auto &job : io_jobs)
+    {
+      evaluate(job);
+    }
+    m_batch.swap(io_jobs);
+    m_submitted = true;
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    assert(!m_submitted && "collect the last batch before submitting another");
+    m_batch.swap(io_jobs);
+    m_submitted = true;
+    m_busy = true;
+  }
+  m_wake.notify_one();
+}
+
+void PosePipeline::collect(std::vector<Job> &o_jobs)
+{
+  std::unique_lock<std::mutex> lock(m_mutex);
+  if (!m_submitted)
+  {
+    o_jobs.clear();
+    return;
+  }
+  m_done.wait(lock, [this]() { return !m_busy; });
+  m_batch.swap(o_jobs);
+  m_submitted = false;
+}
+
+void PosePipeline::workerLoop()
+{
+  std::unique_lock<std::mutex> lock(m_mutex);
+  for (;;)
+  {
+    m_wake.wait(lock, [this]() { return m_busy || m_stop; });
+    if (m_stop)
+    {
+      return;
+    }
+    // the GL thread won't touch the batch until m_busy is cleared so it can be worked on unlocked
+    lock.unlock();
+    for (auto &job : m_batch)
+    {
+      evaluate(job);
+    }
+    lock.lock();
+    m_busy = false;
+    m_done.notify_one();
+  }
+}
@@ -0,0 +1,66 @@
+#include "RenderStats.h"
+#include <iostream>
+
+namespace RenderStats
+{
+  namespace
+  {
+    Counters s_last;
+    // running totals since the last report
+    Counters s_total;
+    uint64_t s_frames=0;
+    size_t s_interval=0;
+    size_t s_framesSinceReport=0;
+  }
+
+  void beginFrame()
+  {
+    s_current=Counters();
+  }
+
+  void endFrame()
+  {
+    s_last=s_current;
+    ++s_frames;
+    if(s_interval == 0)
+    {
+      return;
+    }
+    s_total.drawCalls+=s_current.drawCalls;
+    s_total.triangles+=s_current.triangles;
+    s_total.vaoBinds+=s_current.vaoBinds;
+    s_total.programSwitches+=s_current.programSwitches;
+    s_total.uniformUploads+=s_current.uniformUploads;
+    s_total.bufferBytes+=s_current.bufferBytes;
+    if(++s_framesSinceReport == s_interval)
+    {
+      auto n=static_cast<double>(s_framesSinceReport);
+      std::cout<<"frame "<<s_frames<<" average over "<<s_framesSinceReport<<" frames :"
+               <<" draws "<<s_total.drawCalls/n
+               <<" triangles "<<s_total.triangles/n
+               <<" VAO binds "<<s_total.vaoBinds/n
+               <<" program switches "<<s_total.programSwitches/n
+               <<" uniforms "<<s_total.uniformUploads/n
+               <<" buffer bytes "<<s_total.bufferBytes/n<<"\n";
+      s_total=Counters();
+      s_framesSinceReport=0;
+    }
+  }
+
+  const Counters &lastFrame()
+  {
+    return s_last;
+  }
+
+  uint64_t frameCount()
+  {
+    return s_frames;
+  }
+
+  void setReportInterval(size_t _frames)
+  {
+    s_interval=_frames;
+    s_total=Counters();
+    s_framesSinceReport=0;
+  }
+}
@@ -0,0 +1,152 @@
+#include "ShaderCache.h"
+#include "AssetArchive.h"
+#include <ngl/ShaderLib.h>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+namespace ShaderCache
+{
+  namespace
+  {
+    bool s_enabled = true;
+    std::string s_directory("shadercache");
+
+    bool readText(const std::string &_fname, std::string &o_text)
+    {
+      std::ifstream in(_fname, std::ios::binary);
+      if (!in)
+      {
+        return false;
+      }
+      o_text.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+      return true;
+    }
+
+    std::string glString(GLenum _name)
+    {
+      auto s = reinterpret_cast<const char *>(glGetString(_name));
+      return s != nullptr ? s : "";
+    }
+
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the cache file for this program, sources and driver
+    //----------------------------------------------------------------------------------------------------------------------
+    std::string cacheName(const std::string &_program, const std::string &_vertex, const std::string &_fragment)
+    {
+      // the separators stop different splits of the same text hashing the same
+      std::string key = _vertex + '\0' + _fragment + '\0' + glString(GL_VENDOR) + '\0' +
+                        glString(GL_RENDERER) + '\0' + glString(GL_VERSION);
+      uint64_t hash = AssetArchive::hash(reinterpret_cast<const uint8_t *>(key.data()), key.size());
+      char hex[17];
+      std::snprintf(hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(hash));
+      return s_directory + "/" + _program + "_" + hex + ".bin";
+    }
+
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief load a cached binary into the program, the file is the GLenum format followed by the binary
+    //----------------------------------------------------------------------------------------------------------------------
+    bool loadBinary(GLuint _id, const std::string &_fname)
+    {
+      std::string data;
+      if (!readText(_fname, data) || data.size() <= sizeof(GLenum))
+      {
+        return false;
+      }
+      GLenum format;
+      std::copy(data.begin(), data.begin() + sizeof(GLenum), reinterpret_cast<char *>(&format));
+      glProgramBinary(_id, format, data.data() + sizeof(GLenum), static_cast<GLsizei>(data.size() - sizeof(GLenum)));
+      GLint linked = GL_FALSE;
+      glGetProgramiv(_id, GL_LINK_STATUS, &linked);
+      return linked == GL_TRUE;
+    }
+
+    void saveBinary(GLuint _id, const std::string &_fname)
+    {
+      GLint length = 0;
+      glGetProgramiv(_id, GL_PROGRAM_BINARY_LENGTH, &length);
+      if (length <= 0)
+      {
+        // some drivers support the extension but offer no formats
+        return;
+      }
+      std::vector<char> binary(static_cast<size_t>(length));
+      GLenum format = 0;
+      glGetProgramBinary(_id, length, &length, &format, binary.data());
+      std::error_code error;
+      std::filesystem::create_directories(s_directory, error);
+      std::ofstream out(_fname, std::ios::binary);
+      if (!out)
+      {
+        std::cerr << "ShaderCache unable to write " << _fname << "\n";
+        return;
+      }
+      out.write(reinterpret_cast<const char *>(&format), sizeof(format));
+      out.write(binary.data(), length);
+    }
+
+    double msSince(std::chrono::steady_clock::time_point _start)
+    {
+      return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - _start).count();
+    }
+  } // end anon namespace
+
+  void setEnabled(bool _enabled)
+  {
+    s_enabled = _enabled;
+  }
+
+  void setDirectory(const std::string &_dir)
+  {
+    s_directory = _dir;
+  }
+
+  bool loadProgram(const std::string &_program, const std::string &_vertexFile, const std::string &_fragmentFile)
+  {
+    auto start = std::chrono::steady_clock::now();
+    ngl::ShaderLib::createShaderProgram(_program);
+    GLuint id = ngl::ShaderLib::getProgramID(_program);
+    std::string vertex, fragment, fname;
+    if (s_enabled && readText(_vertexFile, vertex) && readText(_fragmentFile, fragment))
+    {
+      fname = cacheName(_program, vertex, fragment);
+      if (std::filesystem::exists(fname))
+      {
+        if (loadBinary(id, fname))
+        {
+          // ShaderLib looks uniforms up by name so needs to know what the program has
+          ngl::ShaderLib::autoRegisterUniforms(_program);
+          std::cout << "ShaderCache " << _program << " loaded from cache in " << msSince(start) << " ms\n";
+          return true;
+        }
+        std::cout << "ShaderCache driver rejected " << fname << " building from source\n";
+        std::filesystem::remove(fname);
+      }
+    }
+    // the normal ShaderLib build, the program object is re-used if a binary was rejected
+    std::string vertexName = _program + "Vertex";
+    std::string fragmentName = _program + "Fragment";
+    ngl::ShaderLib::attachShader(vertexName, ngl::ShaderType::VERTEX);
+    ngl::ShaderLib::attachShader(fragmentName, ngl::ShaderType::FRAGMENT);
+    ngl::ShaderLib::loadShaderSource(vertexName, _vertexFile);
+    ngl::ShaderLib::loadShaderSource(fragmentName, _fragmentFile);
+    ngl::ShaderLib::compileShader(vertexName);
+    ngl::ShaderLib::compileShader(fragmentName);
+    ngl::ShaderLib::attachShaderToProgram(_program, vertexName);
+    ngl::ShaderLib::attachShaderToProgram(_program, fragmentName);
+    if (!fname.empty())
+    {
+      glProgramParameteri(id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+    bool linked = ngl::ShaderLib::linkProgramObject(_program);
+    std::cout << "ShaderCache " << _program << " compiled from source in " << msSince(start) << " ms\n";
+    if (linked && !fname.empty())
+    {
+      saveBinary(id, fname);
+    }
+    return linked;
+  }
+}
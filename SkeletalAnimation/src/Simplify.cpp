@@ -0,0 +1,353 @@
+#include "Simplify.h"
+#include <ngl/Mat4.h>
+#include <ngl/Vec3.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+
+namespace Simplify
+{
+
+  namespace
+  {
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief symmetric 4x4 quadric matrix, only the upper triangle is stored
+    /// a2 ab ac ad b2 bc bd c2 cd d2
+    //----------------------------------------------------------------------------------------------------------------------
+    struct Quadric
+    {
+      double q[10]={0.0};
+
+      void addPlane(double _a, double _b, double _c, double _d, double _weight)
+      {
+        q[0] += _weight * _a * _a;
+        q[1] += _weight * _a * _b;
+        q[2] += _weight * _a * _c;
+        q[3] += _weight * _a * _d;
+        q[4] += _weight * _b * _b;
+        q[5] += _weight * _b * _c;
+        q[6] += _weight * _b * _d;
+        q[7] += _weight * _c * _c;
+        q[8] += _weight * _c * _d;
+        q[9] += _weight * _d * _d;
+      }
+
+      void add(const Quadric &_o)
+      {
+        for (int i = 0; i < 10; ++i)
+        {
+          q[i] += _o.q[i];
+        }
+      }
+      // v^T Q v for v=(x,y,z,1)
+      double error(double _x, double _y, double _z) const
+      {
+        return q[0] * _x * _x + 2.0 * q[1] * _x * _y + 2.0 * q[2] * _x * _z + 2.0 * q[3] * _x +
+               q[4] * _y * _y + 2.0 * q[5] * _y * _z + 2.0 * q[6] * _y +
+               q[7] * _z * _z + 2.0 * q[8] * _z +
+               q[9];
+      }
+    };
+
+    struct Collapse
+    {
+      double cost;
+      unsigned int from;
+      unsigned int to;
+    };
+
+    // exact position key used to find seams where assimp has split a vertex for uv / normal
+    struct PositionKey
+    {
+      uint32_t x, y, z;
+      bool operator==(const PositionKey &_o) const { return x == _o.x && y == _o.y && z == _o.z; }
+    };
+
+    struct PositionKeyHash
+    {
+      size_t operator()(const PositionKey &_k) const
+      {
+        return (_k.x * 73856093u) ^ (_k.y * 19349663u) ^ (_k.z * 83492791u);
+      }
+    };
+
+    PositionKey makeKey(const float *_p)
+    {
+      PositionKey k;
+      std::memcpy(&k.x, &_p[0], sizeof(uint32_t));
+      std::memcpy(&k.y, &_p[1], sizeof(uint32_t));
+      std::memcpy(&k.z, &_p[2], sizeof(uint32_t));
+      return k;
+    }
+
+    void triNormal(const float *_a, const float *_b, const float *_c, double o_n[3])
+    {
+      double e1[3] = {_b[0] - _a[0], _b[1] - _a[1], _b[2] - _a[2]};
+      double e2[3] = {_c[0] - _a[0], _c[1] - _a[1], _c[2] - _a[2]};
+      o_n[0] = e1[1] * e2[2] - e1[2] * e2[1];
+      o_n[1] = e1[2] * e2[0] - e1[0] * e2[2];
+      o_n[2] = e1[0] * e2[1] - e1[1] * e2[0];
+    }
+  } // end anon namespace
+
+
+  std::vector<unsigned int> simplify(const float *_positions,
+                                     size_t _numVerts,
+                                     size_t _stride,
+                                     const std::vector<unsigned int> &_indices,
+                                     size_t _targetIndexCount,
+                                     const unsigned int *_vertexGroup)
+  {
+    std::vector<unsigned int> indices(_indices);
+    if (_numVerts == 0 || indices.size() <= _targetIndexCount)
+    {
+      return indices;
+    }
+    auto pos = [&](unsigned int _i) { return &_positions[_i * _stride]; };
+
+    // lock any vertex that shares its position with another, moving one copy of a seam
+    // would open a crack in the surface
+    std::vector<bool> locked(_numVerts, false);
+    {
+      std::unordered_map<PositionKey, unsigned int, PositionKeyHash> firstAtPosition;
+      firstAtPosition.reserve(_numVerts);
+      for (unsigned int i = 0; i < _numVerts; ++i)
+      {
+        auto result = firstAtPosition.emplace(makeKey(pos(i)), i);
+        if (result.second == false)
+        {
+          locked[i] = true;
+          locked[result.first->second] = true;
+        }
+      }
+    }
+    // lock open borders, an edge used by only one triangle
+    {
+      std::unordered_map<uint64_t, unsigned int> edgeCount;
+      edgeCount.reserve(indices.size());
+      for (size_t t = 0; t < indices.size(); t += 3)
+      {
+        for (int e = 0; e < 3; ++e)
+        {
+          uint64_t a = indices[t + e];
+          uint64_t b = indices[t + (e + 1) % 3];
+          ++edgeCount[(std::min(a, b) << 32) | std::max(a, b)];
+        }
+      }
+      for (auto &edge : edgeCount)
+      {
+        if (edge.second == 1)
+        {
+          locked[edge.first >> 32] = true;
+          locked[edge.first & 0xffffffff] = true;
+        }
+      }
+    }
+
+    // each vertex quadric is the sum of the (area weighted) planes of the faces around it
+    std::vector<Quadric> quadrics(_numVerts);
+    for (size_t t = 0; t < indices.size(); t += 3)
+    {
+      const float *a = pos(indices[t]);
+      double n[3];
+      triNormal(a, pos(indices[t + 1]), pos(indices[t + 2]), n);
+      double len = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+      if (len <= 0.0)
+      {
+        continue;
+      }
+      n[0] /= len;
+      n[1] /= len;
+      n[2] /= len;
+      double d = -(n[0] * a[0] + n[1] * a[1] + n[2] * a[2]);
+      for (int i = 0; i < 3; ++i)
+      {
+        quadrics[indices[t + i]].addPlane(n[0], n[1], n[2], d, len * 0.5);
+      }
+    }
+
+    std::vector<unsigned int> remap(_numVerts);
+    std::vector<unsigned int> triStart(_numVerts + 1);
+    std::vector<unsigned int> triList;
+    std::vector<bool> touched(_numVerts);
+    std::vector<Collapse> collapses;
+
+    while (indices.size() > _targetIndexCount)
+    {
+      // build vertex -> triangle adjacency for this pass
+      std::fill(triStart.begin(), triStart.end(), 0);
+      for (auto i : indices)
+      {
+        ++triStart[i + 1];
+      }
+      for (size_t i = 0; i < _numVerts; ++i)
+      {
+        triStart[i + 1] += triStart[i];
+      }
+      triList.resize(indices.size());
+      {
+        std::vector<unsigned int> fill(triStart.begin(), triStart.end() - 1);
+        for (size_t t = 0; t < indices.size(); ++t)
+        {
+          triList[fill[indices[t]]++] = static_cast<unsigned int>(t / 3);
+        }
+      }
+
+      // gather every legal half edge collapse and its cost
+      collapses.clear();
+      for (size_t t = 0; t < indices.size(); t += 3)
+      {
+        for (int e = 0; e < 3; ++e)
+        {
+          unsigned int from = indices[t + e];
+          unsigned int to = indices[t + (e + 1) % 3];
+          for (int dir = 0; dir < 2; ++dir, std::swap(from, to))
+          {
+            if (locked[from] || (_vertexGroup && _vertexGroup[from] != _vertexGroup[to]))
+            {
+              continue;
+            }
+            Quadric q = quadrics[from];
+            q.add(quadrics[to]);
+            const float *p = pos(to);
+            collapses.push_back({q.error(p[0], p[1], p[2]), from, to});
+          }
+        }
+      }
+      if (collapses.empty())
+      {
+        break;
+      }
+      std::sort(collapses.begin(), collapses.end(),
+                [](const Collapse &_a, const Collapse &_b) { return _a.cost < _b.cost; });
+
+      for (unsigned int i = 0; i < _numVerts; ++i)
+      {
+        remap[i] = i;
+      }
+      std::fill(touched.begin(), touched.end(), false);
+      size_t trianglesToRemove = (indices.size() - _targetIndexCount) / 3;
+      size_t removed = 0;
+      size_t applied = 0;
+
+      for (auto &c : collapses)
+      {
+        if (removed >= trianglesToRemove)
+        {
+          break;
+        }
+        if (touched[c.from] || touched[c.to])
+        {
+          continue;
+        }
+        // reject the collapse if any of the triangles that survive it would flip over
+        bool flips = false;
+        size_t lost = 0;
+        for (unsigned int a = triStart[c.from]; a < triStart[c.from + 1] && !flips; ++a)
+        {
+          size_t t = triList[a] * 3;
+          unsigned int v[3] = {indices[t], indices[t + 1], indices[t + 2]};
+          if (v[0] == c.to || v[1] == c.to || v[2] == c.to)
+          {
+            ++lost;
+            continue;
+          }
+          double before[3], after[3];
+          triNormal(pos(v[0]), pos(v[1]), pos(v[2]), before);
+          for (auto &i : v)
+          {
+            i = (i == c.from) ? c.to : i;
+          }
+          triNormal(pos(v[0]), pos(v[1]), pos(v[2]), after);
+          flips = (before[0] * after[0] + before[1] * after[1] + before[2] * after[2]) <= 0.0;
+        }
+        if (flips)
+        {
+          continue;
+        }
+        remap[c.from] = c.to;
+        quadrics[c.to].add(quadrics[c.from]);
+        // anything around from now has stale adjacency so leave it until the next pass
+        for (unsigned int a = triStart[c.from]; a < triStart[c.from + 1]; ++a)
+        {
+          size_t t = triList[a] * 3;
+          touched[indices[t]] = touched[indices[t + 1]] = touched[indices[t + 2]] = true;
+        }
+        removed += lost;
+        ++applied;
+      }
+      if (applied == 0)
+      {
+        break;
+      }
+
+      // apply the collapses and drop the triangles that are now degenerate
+      size_t write = 0;
+      for (size_t t = 0; t < indices.size(); t += 3)
+      {
+        unsigned int a = remap[indices[t]];
+        unsigned int b = remap[indices[t + 1]];
+        unsigned int c = remap[indices[t + 2]];
+        if (a != b && b != c && a != c)
+        {
+          indices[write++] = a;
+          indices[write++] = b;
+          indices[write++] = c;
+        }
+      }
+      indices.resize(write);
+    }
+    return indices;
+  }
+
+  void buildLODChain(const float *_positions,
+                     size_t _numVerts,
+                     size_t _stride,
+                     const std::vector<unsigned int> &_indices,
+                     std::vector<std::vector<unsigned int>> &o_lods,
+                     const unsigned int *_vertexGroup)
+  {
+    o_lods.clear();
+    o_lods.push_back(_indices);
+    while (o_lods.size() < s_maxLODs)
+    {
+      const auto &previous = o_lods.back();
+      auto next = simplify(_positions, _numVerts, _stride, previous, (previous.size() / 6) * 3, _vertexGroup);
+      // not worth another level if we couldn't get rid of at least a quarter of the triangles
+      if (next.empty() || next.size() > (previous.size() * s_lodKeepNumerator) / s_lodKeepDenominator)
+      {
+        break;
+      }
+      o_lods.push_back(std::move(next));
+    }
+  }
+
+  float projectedSize(const ngl::Mat4 &_MV, const ngl::Mat4 &_project, const ngl::Vec3 &_centre, float _radius)
+  {
+    // the matrices are in the layout we upload to GL so the eye space z is the third row
+    float z = _MV.m_m[0][2] * _centre.m_x + _MV.m_m[1][2] * _centre.m_y + _MV.m_m[2][2] * _centre.m_z + _MV.m_m[3][2];
+    float distance = -z;
+    if (distance <= _radius)
+    {
+      // we are inside the sphere so treat it as filling the screen
+      return 1.0f;
+    }
+    // m_m[1][1] is cot(fov/2) so this is the diameter in normalised device units over the 2 unit range
+    return (_radius * _project.m_m[1][1]) / distance;
+  }
+
+  size_t selectLOD(float _projectedSize, size_t _numLODs)
+  {
+    size_t lod = 0;
+    float threshold = 0.5f;
+    while (lod + 1 < _numLODs && _projectedSize < threshold)
+    {
+      ++lod;
+      threshold *= 0.5f;
+    }
+    return lod;
+  }
+
+} // end namespace
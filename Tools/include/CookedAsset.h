@@ -0,0 +1,63 @@
+#ifndef COOKEDASSET_H_
+#define COOKEDASSET_H_
+#include <cstdint>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @file CookedAsset.h
+/// @brief the layout of the files written by AssetCooker. Everything is little endian and each section
+/// starts on a 16 byte boundary so the vertex streams can be handed to glBufferData straight from a mapping.
+/// After the Header the sections are, in order
+/// dependencies numDependencies * (string path, uint64 size, int64 time, uint64 hash) every other file the
+///             importer opened (md5anim, materials, textures etc.), then aligned to 16 bytes
+/// positions   numVertices * float[3]
+/// texCoords   numVertices * float[2]
+/// normals     numVertices * float[3]
+/// boneData    numVertices * (uint32 ids[4], float weights[4])  (the attribute 3 / 4 layout the viewers use)
+/// indices     numIndices * uint32, the LOD levels follow the full mesh as in Mesh
+/// entries     numEntries * Entry
+/// bones       numBones * (string name, float offset[16], float boundsMin[3], float boundsMax[3], uint32 hasBounds)
+/// nodes       numNodes * (string name, int32 parent, float transform[16]) depth first so parents come first
+/// clips       numClips * (string name, float duration, float ticksPerSecond, uint32 numChannels, channels)
+/// channel     int32 node, uint32 numPositions, numRotations, numScales then the keys as
+///             (float time, float x, y, z), (float time, float w, x, y, z), (float time, float x, y, z)
+/// strings are a uint32 length followed by the bytes, matrices are in NGL (column major) order so the
+/// translation is in elements 12-14 (assimp and Mesh::BoneInfo::boneOffset hold them row major)
+//----------------------------------------------------------------------------------------------------------------------
+namespace Cooked
+{
+  constexpr char s_magic[4] = {'A', 'I', 'C', 'K'};
+  constexpr uint32_t s_version = 3;
+  constexpr uint32_t s_maxLODs = 4;
+  constexpr uint32_t s_alignment = 16;
+
+  struct Header
+  {
+    char magic[4];
+    uint32_t version;
+    /// @brief what the file was cooked from, used for incremental rebuilds
+    uint64_t sourceSize;
+    int64_t sourceTime;
+    uint64_t sourceHash;
+    uint32_t importFlags;
+    uint32_t numVertices;
+    uint32_t numIndices;
+    uint32_t numEntries;
+    uint32_t numBones;
+    uint32_t numNodes;
+    uint32_t numClips;
+    /// @brief bind pose bounds of the whole model
+    float boundsMin[3];
+    float boundsMax[3];
+    uint32_t numDependencies;
+  };
+
+  struct Entry
+  {
+    uint32_t baseVertex;
+    uint32_t numLODs;
+    uint32_t lodBaseIndex[s_maxLODs];
+    uint32_t lodNumIndices[s_maxLODs];
+  };
+}
+
+#endif
@@ -0,0 +1,857 @@
+/****************************************************************************
+Cooks every model in a directory into a GPU ready file (see CookedAsset.h)
+using a pool of threads. Each file goes through the same import and
+conversion as the SkeletalAnimation viewer, files whose source has not
+changed since the last cook are skipped.
+****************************************************************************/
+#include "AIUtil.h"
+#include "AssetArchive.h"
+#include "CookedAsset.h"
+#include "ImportProfile.h"
+#include "MappedIOSystem.h"
+#include "Mesh.h"
+#include <assimp/Importer.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief what happened to one source file
+//----------------------------------------------------------------------------------------------------------------------
+struct CookResult
+{
+  enum class Status
+  {
+    Cooked,
+    UpToDate,
+    Failed
+  };
+  std::string source;
+  std::string output;
+  Status status = Status::Failed;
+  std::string error;
+  uint64_t sourceBytes = 0;
+  uint64_t cookedBytes = 0;
+  uint32_t vertices = 0;
+  uint32_t indices = 0;
+  uint32_t entries = 0;
+  uint32_t bones = 0;
+  uint32_t clips = 0;
+  double ms = 0.0;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief appends binary data to a buffer, the file is built in memory and written in one go
+//----------------------------------------------------------------------------------------------------------------------
+class Writer
+{
+  public :
+    template <typename T>
+    void put(const T &_value)
+    {
+      m_data.append(reinterpret_cast<const char *>(&_value), sizeof(T));
+    }
+    void put(const void *_data, size_t _size)
+    {
+      m_data.append(static_cast<const char *>(_data), _size);
+    }
+    void putString(const std::string &_s)
+    {
+      put(static_cast<uint32_t>(_s.size()));
+      m_data += _s;
+    }
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief write a matrix held in assimp (row major) order as column major
+    //----------------------------------------------------------------------------------------------------------------------
+    void putMatrix(ngl::Mat4 _m)
+    {
+      _m.transpose();
+      put(&_m.m_00, sizeof(float) * 16);
+    }
+    void align()
+    {
+      m_data.resize((m_data.size() + Cooked::s_alignment - 1) & ~size_t(Cooked::s_alignment - 1), '\0');
+    }
+    std::string &data() { return m_data; }
+
+  private :
+    std::string m_data;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief reads back what Writer wrote, every get fails rather than reading past the end
+//----------------------------------------------------------------------------------------------------------------------
+class Reader
+{
+  public :
+    explicit Reader(const std::string &_data) : m_data(_data) {}
+    template <typename T>
+    bool get(T &o_value)
+    {
+      return get(&o_value, sizeof(T));
+    }
+    bool get(void *o_data, size_t _size)
+    {
+      if (_size > m_data.size() - m_pos)
+      {
+        return false;
+      }
+      std::memcpy(o_data, m_data.data() + m_pos, _size);
+      m_pos += _size;
+      return true;
+    }
+    bool getString(std::string &o_s)
+    {
+      uint32_t size = 0;
+      if (!get(size) || size > m_data.size() - m_pos)
+      {
+        return false;
+      }
+      o_s.assign(m_data, m_pos, size);
+      m_pos += size;
+      return true;
+    }
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief read a column major matrix, this is left in NGL order
+    //----------------------------------------------------------------------------------------------------------------------
+    bool getMatrix(ngl::Mat4 &o_m)
+    {
+      return get(&o_m.m_00, sizeof(float) * 16);
+    }
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief compare the next _size bytes with _expected
+    //----------------------------------------------------------------------------------------------------------------------
+    bool same(const void *_expected, size_t _size)
+    {
+      if (_size > m_data.size() - m_pos || std::memcmp(m_data.data() + m_pos, _expected, _size) != 0)
+      {
+        return false;
+      }
+      m_pos += _size;
+      return true;
+    }
+    void align()
+    {
+      m_pos = std::min(m_data.size(), (m_pos + Cooked::s_alignment - 1) & ~size_t(Cooked::s_alignment - 1));
+    }
+
+  private :
+    const std::string &m_data;
+    size_t m_pos = 0;
+};
+
+static bool sameMatrix(const ngl::Mat4 &_a, const ngl::Mat4 &_b)
+{
+  return std::memcmp(&_a.m_00, &_b.m_00, sizeof(float) * 16) == 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief write the node hierarchy depth first, recording each node's index so channels can refer to it
+//----------------------------------------------------------------------------------------------------------------------
+static void writeNodes(Writer &_out, const aiNode *_node, int32_t _parent, std::vector<std::string> &io_names)
+{
+  int32_t index = static_cast<int32_t>(io_names.size());
+  io_names.push_back(_node->mName.data);
+  _out.putString(_node->mName.data);
+  _out.put(_parent);
+  _out.putMatrix(AIU::aiMatrix4x4ToNGLMat4(_node->mTransformation));
+  for (unsigned int i = 0; i < _node->mNumChildren; ++i)
+  {
+    writeNodes(_out, _node->mChildren[i], index, io_names);
+  }
+}
+
+static bool verifyNodes(Reader &_in, const aiNode *_node, int32_t _parent, int32_t &io_count)
+{
+  int32_t index = io_count++;
+  std::string name;
+  int32_t parent = 0;
+  ngl::Mat4 transform;
+  if (!_in.getString(name) || !_in.get(parent) || !_in.getMatrix(transform) || name != _node->mName.data ||
+      parent != _parent || !sameMatrix(transform, AIU::aiMatrix4x4ToNGLMat4Transpose(_node->mTransformation)))
+  {
+    return false;
+  }
+  for (unsigned int i = 0; i < _node->mNumChildren; ++i)
+  {
+    if (!verifyNodes(_in, _node->mChildren[i], index, io_count))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+static uint32_t countNodes(const aiNode *_node)
+{
+  uint32_t count = 1;
+  for (unsigned int i = 0; i < _node->mNumChildren; ++i)
+  {
+    count += countNodes(_node->mChildren[i]);
+  }
+  return count;
+}
+
+static void writeClips(Writer &_out, const aiScene *_scene, const std::vector<std::string> &_nodeNames)
+{
+  for (unsigned int a = 0; a < _scene->mNumAnimations; ++a)
+  {
+    const aiAnimation *anim = _scene->mAnimations[a];
+    _out.putString(anim->mName.data);
+    _out.put(static_cast<float>(anim->mDuration));
+    _out.put(static_cast<float>(anim->mTicksPerSecond != 0.0 ? anim->mTicksPerSecond : 25.0));
+    _out.put(static_cast<uint32_t>(anim->mNumChannels));
+    for (unsigned int c = 0; c < anim->mNumChannels; ++c)
+    {
+      const aiNodeAnim *channel = anim->mChannels[c];
+      auto node = std::find(_nodeNames.begin(), _nodeNames.end(), std::string(channel->mNodeName.data));
+      _out.put(node == _nodeNames.end() ? int32_t(-1) : static_cast<int32_t>(node - _nodeNames.begin()));
+      _out.put(static_cast<uint32_t>(channel->mNumPositionKeys));
+      _out.put(static_cast<uint32_t>(channel->mNumRotationKeys));
+      _out.put(static_cast<uint32_t>(channel->mNumScalingKeys));
+      for (unsigned int k = 0; k < channel->mNumPositionKeys; ++k)
+      {
+        auto &key = channel->mPositionKeys[k];
+        float v[4] = {static_cast<float>(key.mTime), key.mValue.x, key.mValue.y, key.mValue.z};
+        _out.put(v, sizeof(v));
+      }
+      for (unsigned int k = 0; k < channel->mNumRotationKeys; ++k)
+      {
+        auto &key = channel->mRotationKeys[k];
+        float v[5] = {static_cast<float>(key.mTime), key.mValue.w, key.mValue.x, key.mValue.y, key.mValue.z};
+        _out.put(v, sizeof(v));
+      }
+      for (unsigned int k = 0; k < channel->mNumScalingKeys; ++k)
+      {
+        auto &key = channel->mScalingKeys[k];
+        float v[4] = {static_cast<float>(key.mTime), key.mValue.x, key.mValue.y, key.mValue.z};
+        _out.put(v, sizeof(v));
+      }
+    }
+  }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief a file other than the source that the importer read, recorded so a change to it causes a re-cook
+//----------------------------------------------------------------------------------------------------------------------
+struct Dependency
+{
+  std::string path;
+  uint64_t size = 0;
+  int64_t time = 0;
+  uint64_t hash = 0;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief a MappedIOSystem that remembers every file opened for reading, so the files a model pulls in
+/// can be recorded in the cooked header
+//----------------------------------------------------------------------------------------------------------------------
+class RecordingIOSystem : public MappedIOSystem
+{
+  public :
+    using MappedIOSystem::Open;
+    Assimp::IOStream *Open(const char *_file, const char *_mode = "rb") override
+    {
+      Assimp::IOStream *stream = MappedIOSystem::Open(_file, _mode);
+      if (stream != nullptr && _mode[0] == 'r')
+      {
+        m_opened.insert(_file);
+      }
+      return stream;
+    }
+    const std::set<std::string> &opened() const { return m_opened; }
+
+  private :
+    std::set<std::string> m_opened;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief read the header and dependency list of an existing cooked file
+//----------------------------------------------------------------------------------------------------------------------
+static bool readHeader(const fs::path &_fname, Cooked::Header &o_header, std::vector<Dependency> &o_dependencies)
+{
+  std::ifstream in(_fname, std::ios::binary);
+  if (!in.read(reinterpret_cast<char *>(&o_header), sizeof(o_header)) ||
+      std::memcmp(o_header.magic, Cooked::s_magic, sizeof(Cooked::s_magic)) != 0 || o_header.version != Cooked::s_version)
+  {
+    return false;
+  }
+  o_dependencies.resize(o_header.numDependencies);
+  for (auto &d : o_dependencies)
+  {
+    uint32_t length = 0;
+    // a path longer than this means the file is corrupt
+    if (!in.read(reinterpret_cast<char *>(&length), sizeof(length)) || length > 4096)
+    {
+      return false;
+    }
+    d.path.resize(length);
+    in.read(&d.path[0], length);
+    in.read(reinterpret_cast<char *>(&d.size), sizeof(d.size));
+    in.read(reinterpret_cast<char *>(&d.time), sizeof(d.time));
+    in.read(reinterpret_cast<char *>(&d.hash), sizeof(d.hash));
+  }
+  return static_cast<bool>(in);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief the header and dependency list, these are also re-written in place when only file times change
+//----------------------------------------------------------------------------------------------------------------------
+static void putHeader(Writer &_out, const Cooked::Header &_header, const std::vector<Dependency> &_dependencies)
+{
+  _out.put(_header);
+  for (auto &d : _dependencies)
+  {
+    _out.putString(d.path);
+    _out.put(d.size);
+    _out.put(d.time);
+    _out.put(d.hash);
+  }
+}
+
+static bool readFile(const fs::path &_fname, std::string &o_data)
+{
+  std::ifstream in(_fname, std::ios::binary);
+  if (!in)
+  {
+    return false;
+  }
+  o_data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+  return true;
+}
+
+// size and modification time of a file
+static bool stampFile(const fs::path &_fname, uint64_t &o_size, int64_t &o_time)
+{
+  std::error_code error;
+  o_size = fs::file_size(_fname, error);
+  if (error)
+  {
+    return false;
+  }
+  o_time = static_cast<int64_t>(fs::last_write_time(_fname, error).time_since_epoch().count());
+  return !error;
+}
+
+static bool hashFile(const fs::path &_fname, uint64_t &o_hash)
+{
+  std::string contents;
+  if (!readFile(_fname, contents))
+  {
+    return false;
+  }
+  o_hash = AssetArchive::hash(reinterpret_cast<const uint8_t *>(contents.data()), contents.size());
+  return true;
+}
+
+enum class Stamp
+{
+  Same,
+  Touched,
+  Changed
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief compare a file with what was recorded when it was cooked, a file whose size and time match is assumed
+/// unchanged. If only the time differs the contents are hashed and io_time is updated when they are the same
+//----------------------------------------------------------------------------------------------------------------------
+static Stamp checkFile(const fs::path &_fname, uint64_t _size, int64_t &io_time, uint64_t _hash)
+{
+  uint64_t size = 0;
+  int64_t time = 0;
+  if (!stampFile(_fname, size, time) || size != _size)
+  {
+    return Stamp::Changed;
+  }
+  if (time == io_time)
+  {
+    return Stamp::Same;
+  }
+  uint64_t hash = 0;
+  if (!hashFile(_fname, hash) || hash != _hash)
+  {
+    return Stamp::Changed;
+  }
+  io_time = time;
+  return Stamp::Touched;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief read a cooked file back and check it against what Mesh::loadData produced for the same scene, the
+/// node matrices are checked against assimp directly so the column major order is tested too
+/// @returns an empty string if everything matches else the first section that didn't
+//----------------------------------------------------------------------------------------------------------------------
+static std::string verifyCooked(const std::string &_file, const aiScene *_scene, const Mesh &_mesh, const Mesh::GeometryData &_data)
+{
+  Reader in(_file);
+  Cooked::Header header;
+  if (!in.get(header) || header.numVertices != _data.positions.size() || header.numIndices != _data.indices.size() ||
+      header.numEntries != _mesh.entries().size() || header.numBones != _mesh.numBones())
+  {
+    return "header";
+  }
+  for (uint32_t d = 0; d < header.numDependencies; ++d)
+  {
+    std::string path;
+    uint64_t values[3];
+    if (!in.getString(path) || !in.get(values, sizeof(values)))
+    {
+      return "dependencies";
+    }
+  }
+  in.align();
+  if (!in.same(_data.positions.data(), _data.positions.size() * sizeof(ngl::Vec3)))
+  {
+    return "positions";
+  }
+  in.align();
+  if (!in.same(_data.texCoords.data(), _data.texCoords.size() * sizeof(ngl::Vec2)))
+  {
+    return "texCoords";
+  }
+  in.align();
+  if (!in.same(_data.normals.data(), _data.normals.size() * sizeof(ngl::Vec3)))
+  {
+    return "normals";
+  }
+  in.align();
+  if (!in.same(_data.bones.data(), _data.bones.size() * sizeof(Mesh::VertexBoneData)))
+  {
+    return "boneData";
+  }
+  in.align();
+  if (!in.same(_data.indices.data(), _data.indices.size() * sizeof(unsigned int)))
+  {
+    return "indices";
+  }
+  in.align();
+  for (auto &e : _mesh.entries())
+  {
+    Cooked::Entry entry;
+    if (!in.get(entry) || entry.baseVertex != e.BaseVertex || entry.numLODs != e.NumLODs)
+    {
+      return "entries";
+    }
+    for (size_t l = 0; l < e.NumLODs; ++l)
+    {
+      if (entry.lodBaseIndex[l] != e.LODBaseIndex[l] || entry.lodNumIndices[l] != e.LODNumIndices[l])
+      {
+        return "entries";
+      }
+    }
+  }
+  in.align();
+  for (unsigned int b = 0; b < _mesh.numBones(); ++b)
+  {
+    std::string name;
+    ngl::Mat4 offset;
+    float bounds[6];
+    uint32_t hasBounds;
+    if (!in.getString(name) || !in.getMatrix(offset) || !in.get(bounds, sizeof(bounds)) || !in.get(hasBounds))
+    {
+      return "bones";
+    }
+    // back to the row major order Mesh uses
+    offset.transpose();
+    auto mapping = _mesh.boneMapping().find(name);
+    if (mapping == _mesh.boneMapping().end() || mapping->second != b || !sameMatrix(offset, _mesh.boneInfo()[b].boneOffset))
+    {
+      return "bones";
+    }
+  }
+  in.align();
+  int32_t count = 0;
+  if (!verifyNodes(in, _scene->mRootNode, -1, count))
+  {
+    return "nodes";
+  }
+  return std::string();
+}
+
+static CookResult cookFile(const fs::path &_source, const fs::path &_output, unsigned int _flags, bool _force, bool _verify)
+{
+  CookResult result;
+  result.source = _source.generic_string();
+  result.output = _output.generic_string();
+  auto start = std::chrono::steady_clock::now();
+  auto finish = [&]() {
+    result.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return result;
+  };
+
+  std::error_code error;
+  Cooked::Header old;
+  std::vector<Dependency> oldDependencies;
+  if (!_force && readHeader(_output, old, oldDependencies) && old.importFlags == _flags)
+  {
+    // the source and everything it pulled in must be unchanged, a file that has only been touched
+    // just gets its new time recorded so it isn't hashed again next time
+    Stamp stamp = checkFile(_source, old.sourceSize, old.sourceTime, old.sourceHash);
+    bool touched = stamp == Stamp::Touched;
+    for (size_t d = 0; d < oldDependencies.size() && stamp != Stamp::Changed; ++d)
+    {
+      auto &dependency = oldDependencies[d];
+      stamp = checkFile(dependency.path, dependency.size, dependency.time, dependency.hash);
+      touched |= stamp == Stamp::Touched;
+    }
+    if (stamp != Stamp::Changed)
+    {
+      if (touched)
+      {
+        // the paths are the same so the header is the same size
+        Writer header;
+        putHeader(header, old, oldDependencies);
+        std::fstream out(_output, std::ios::binary | std::ios::in | std::ios::out);
+        out.write(header.data().data(), static_cast<std::streamsize>(header.data().size()));
+      }
+      result.status = CookResult::Status::UpToDate;
+      result.sourceBytes = old.sourceSize;
+      result.cookedBytes = fs::file_size(_output, error);
+      return finish();
+    }
+  }
+  int64_t sourceTime = 0;
+  uint64_t hash = 0;
+  if (!stampFile(_source, result.sourceBytes, sourceTime) || !hashFile(_source, hash))
+  {
+    result.error = "unable to read source";
+    return finish();
+  }
+
+  // each thread has its own importer, they are not safe to share
+  Assimp::Importer importer;
+  // the importer owns the IO system
+  auto *io = new RecordingIOSystem;
+  importer.SetIOHandler(io);
+  const aiScene *scene = ImportProfile::readFile(importer, _source.string(), _flags, false);
+  if (scene == nullptr)
+  {
+    result.error = importer.GetErrorString();
+    return finish();
+  }
+  std::vector<Dependency> dependencies;
+  for (auto &opened : io->opened())
+  {
+    if (fs::path(opened).lexically_normal() == _source.lexically_normal())
+    {
+      continue;
+    }
+    Dependency dependency;
+    dependency.path = opened;
+    if (!stampFile(opened, dependency.size, dependency.time) || !hashFile(opened, dependency.hash))
+    {
+      result.error = "unable to read " + opened;
+      return finish();
+    }
+    dependencies.push_back(dependency);
+  }
+  Mesh mesh;
+  Mesh::GeometryData data;
+  if (!mesh.loadData(scene, data))
+  {
+    result.error = "conversion failed";
+    return finish();
+  }
+
+  Cooked::Header header = {};
+  std::memcpy(header.magic, Cooked::s_magic, sizeof(header.magic));
+  header.version = Cooked::s_version;
+  header.sourceSize = result.sourceBytes;
+  header.sourceTime = sourceTime;
+  header.sourceHash = hash;
+  header.importFlags = _flags;
+  header.numVertices = static_cast<uint32_t>(data.positions.size());
+  header.numIndices = static_cast<uint32_t>(data.indices.size());
+  header.numEntries = static_cast<uint32_t>(mesh.entries().size());
+  header.numBones = mesh.numBones();
+  header.numNodes = countNodes(scene->mRootNode);
+  header.numClips = scene->mNumAnimations;
+  header.numDependencies = static_cast<uint32_t>(dependencies.size());
+  ngl::Vec3 min(1e10f, 1e10f, 1e10f);
+  ngl::Vec3 max(-1e10f, -1e10f, -1e10f);
+  for (auto &p : data.positions)
+  {
+    min.set(std::min(min.m_x, p.m_x), std::min(min.m_y, p.m_y), std::min(min.m_z, p.m_z));
+    max.set(std::max(max.m_x, p.m_x), std::max(max.m_y, p.m_y), std::max(max.m_z, p.m_z));
+  }
+  std::memcpy(header.boundsMin, &min.m_x, sizeof(header.boundsMin));
+  std::memcpy(header.boundsMax, &max.m_x, sizeof(header.boundsMax));
+
+  Writer out;
+  putHeader(out, header, dependencies);
+  // the streams in the same layout the VAO is built from
+  out.align();
+  out.put(data.positions.data(), data.positions.size() * sizeof(ngl::Vec3));
+  out.align();
+  out.put(data.texCoords.data(), data.texCoords.size() * sizeof(ngl::Vec2));
+  out.align();
+  out.put(data.normals.data(), data.normals.size() * sizeof(ngl::Vec3));
+  out.align();
+  out.put(data.bones.data(), data.bones.size() * sizeof(Mesh::VertexBoneData));
+  out.align();
+  out.put(data.indices.data(), data.indices.size() * sizeof(unsigned int));
+  out.align();
+  for (auto &e : mesh.entries())
+  {
+    Cooked::Entry entry = {};
+    entry.baseVertex = e.BaseVertex;
+    entry.numLODs = e.NumLODs;
+    for (size_t l = 0; l < e.NumLODs; ++l)
+    {
+      entry.lodBaseIndex[l] = e.LODBaseIndex[l];
+      entry.lodNumIndices[l] = e.LODNumIndices[l];
+    }
+    out.put(entry);
+  }
+  out.align();
+  // bones in index order
+  std::vector<std::string> boneNames(mesh.numBones());
+  for (auto &b : mesh.boneMapping())
+  {
+    boneNames[b.second] = b.first;
+  }
+  for (unsigned int b = 0; b < mesh.numBones(); ++b)
+  {
+    auto &info = mesh.boneInfo()[b];
+    out.putString(boneNames[b]);
+    out.putMatrix(info.boneOffset);
+    out.put(&info.boundsMin.m_x, sizeof(float) * 3);
+    out.put(&info.boundsMax.m_x, sizeof(float) * 3);
+    out.put(static_cast<uint32_t>(info.hasBounds));
+  }
+  out.align();
+  std::vector<std::string> nodeNames;
+  writeNodes(out, scene->mRootNode, -1, nodeNames);
+  out.align();
+  writeClips(out, scene, nodeNames);
+
+  fs::create_directories(_output.parent_path(), error);
+  // write to a temporary and rename so an interrupted cook never leaves a half written file
+  fs::path temp = _output;
+  temp += ".tmp";
+  {
+    std::ofstream file(temp, std::ios::binary);
+    if (!file.write(out.data().data(), static_cast<std::streamsize>(out.data().size())))
+    {
+      result.error = "unable to write " + temp.string();
+      return finish();
+    }
+  }
+  fs::rename(temp, _output, error);
+  if (error)
+  {
+    result.error = error.message();
+    return finish();
+  }
+  // read back what actually landed on disk
+  if (_verify)
+  {
+    std::string written;
+    std::string section = readFile(_output, written) ? verifyCooked(written, scene, mesh, data) : "read";
+    if (!section.empty())
+    {
+      result.error = "verify failed in " + section;
+      return finish();
+    }
+  }
+  result.status = CookResult::Status::Cooked;
+  result.cookedBytes = out.data().size();
+  result.vertices = header.numVertices;
+  result.indices = header.numIndices;
+  result.entries = header.numEntries;
+  result.bones = header.numBones;
+  result.clips = header.numClips;
+  return finish();
+}
+
+static const char *statusName(CookResult::Status _status)
+{
+  switch (_status)
+  {
+  case CookResult::Status::Cooked:
+    return "cooked";
+  case CookResult::Status::UpToDate:
+    return "upToDate";
+  default:
+    return "failed";
+  }
+}
+
+static std::string jsonEscape(const std::string &_s)
+{
+  std::string out;
+  for (char c : _s)
+  {
+    if (c == '"' || c == '\\')
+    {
+      out += '\\';
+    }
+    out += (c == '\n') ? ' ' : c;
+  }
+  return out;
+}
+
+int main(int argc, char **argv)
+{
+  // usage AssetCooker [--out dir] [--threads n] [--profile fast|balanced|max] [--force] [--verify] models
+  fs::path outDir("Cooked");
+  fs::path models;
+  size_t threads = std::max(1u, std::thread::hardware_concurrency());
+  bool force = false;
+  bool verify = false;
+  unsigned int flags = 0;
+  ImportProfile::flagsForProfile("balanced", flags);
+  // a bad number (--threads x) throws, treat it like any other bad argument and print the usage
+  try
+  {
+    for (int i = 1; i < argc; ++i)
+    {
+      std::string arg(argv[i]);
+      if (arg == "--out" && i + 1 < argc)
+      {
+        outDir = argv[++i];
+      }
+      else if (arg == "--threads" && i + 1 < argc)
+      {
+        threads = std::max(1ul, std::stoul(argv[++i]));
+      }
+      else if (arg == "--profile" && i + 1 < argc)
+      {
+        if (!ImportProfile::flagsForProfile(argv[++i], flags))
+        {
+          std::cout << "unknown profile " << argv[i] << " use one of " << ImportProfile::profileNames() << "\n";
+          return EXIT_FAILURE;
+        }
+      }
+      else if (arg == "--force")
+      {
+        force = true;
+      }
+      else if (arg == "--verify")
+      {
+        verify = true;
+      }
+      else if (models.empty() && arg[0] != '-')
+      {
+        models = arg;
+      }
+      else
+      {
+        models.clear();
+        break;
+      }
+    }
+  }
+  catch (const std::exception &)
+  {
+    models.clear();
+  }
+  if (models.empty() || !fs::is_directory(models))
+  {
+    std::cout << "usage AssetCooker [--out dir] [--threads n] [--profile " << ImportProfile::profileNames() << "] [--force] [--verify] models\n";
+    return EXIT_FAILURE;
+  }
+
+  // everything assimp can load, sorted so the manifest is stable
+  std::vector<fs::path> files;
+  Assimp::Importer probe;
+  for (auto &entry : fs::recursive_directory_iterator(models))
+  {
+    if (entry.is_regular_file() && probe.IsExtensionSupported(entry.path().extension().string()))
+    {
+      files.push_back(entry.path());
+    }
+  }
+  std::sort(files.begin(), files.end());
+  threads = std::min(threads, std::max<size_t>(files.size(), 1));
+
+  // a simple pool, each worker takes the next file until there are none left. Results go straight
+  // into their own slot so only the progress output needs a lock
+  std::vector<CookResult> results(files.size());
+  std::atomic<size_t> next{0};
+  std::mutex printLock;
+  auto start = std::chrono::steady_clock::now();
+  auto worker = [&]() {
+    for (size_t i = next++; i < files.size(); i = next++)
+    {
+      fs::path output = outDir / fs::relative(files[i], models);
+      output += ".cooked";
+      results[i] = cookFile(files[i], output, flags, force, verify);
+      std::lock_guard<std::mutex> lock(printLock);
+      std::cout << statusName(results[i].status) << " " << results[i].source << " " << results[i].ms << " ms";
+      if (!results[i].error.empty())
+      {
+        std::cout << " " << results[i].error;
+      }
+      std::cout << "\n";
+    }
+  };
+  std::vector<std::thread> pool;
+  for (size_t t = 0; t < threads; ++t)
+  {
+    pool.emplace_back(worker);
+  }
+  for (auto &t : pool)
+  {
+    t.join();
+  }
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  size_t cooked = 0;
+  size_t failed = 0;
+  uint64_t cookedSourceBytes = 0;
+  for (auto &r : results)
+  {
+    cooked += r.status == CookResult::Status::Cooked ? 1 : 0;
+    failed += r.status == CookResult::Status::Failed ? 1 : 0;
+    cookedSourceBytes += r.status == CookResult::Status::Cooked ? r.sourceBytes : 0;
+  }
+  // throughput is for the files actually cooked, skipped ones cost next to nothing
+  double filesPerSec = seconds > 0.0 ? cooked / seconds : 0.0;
+  double mbPerSec = seconds > 0.0 ? cookedSourceBytes / (1024.0 * 1024.0) / seconds : 0.0;
+  std::cout << cooked << " cooked " << results.size() - cooked - failed << " up to date " << failed << " failed in "
+            << seconds << " s on " << threads << " threads, " << filesPerSec << " files/sec " << mbPerSec << " MB/sec\n";
+
+  fs::create_directories(outDir);
+  fs::path manifestName = outDir / "manifest.json";
+  std::ofstream manifest(manifestName);
+  if (!manifest)
+  {
+    std::cerr << "unable to write " << manifestName << "\n";
+    return EXIT_FAILURE;
+  }
+  manifest << "{\n  \"version\": " << Cooked::s_version << ",\n  \"importFlags\": " << flags
+           << ",\n  \"threads\": " << threads << ",\n  \"seconds\": " << seconds
+           << ",\n  \"filesPerSec\": " << filesPerSec << ",\n  \"MBPerSec\": " << mbPerSec
+           << ",\n  \"cooked\": " << cooked << ",\n  \"failed\": " << failed << ",\n  \"files\": [\n";
+  for (size_t i = 0; i < results.size(); ++i)
+  {
+    auto &r = results[i];
+    manifest << "    {\"source\": \"" << jsonEscape(r.source) << "\", \"output\": \"" << jsonEscape(r.output)
+             << "\", \"status\": \"" << statusName(r.status) << "\", \"ms\": " << r.ms
+             << ", \"sourceBytes\": " << r.sourceBytes << ", \"cookedBytes\": " << r.cookedBytes;
+    if (r.status == CookResult::Status::Cooked)
+    {
+      manifest << ", \"vertices\": " << r.vertices << ", \"indices\": " << r.indices << ", \"meshes\": " << r.entries
+               << ", \"bones\": " << r.bones << ", \"clips\": " << r.clips;
+    }
+    if (!r.error.empty())
+    {
+      manifest << ", \"error\": \"" << jsonEscape(r.error) << "\"";
+    }
+    manifest << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+  }
+  manifest << "  ]\n}\n";
+  return failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
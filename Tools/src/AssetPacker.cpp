@@ -0,0 +1,88 @@
+/****************************************************************************
+Packs a directory (or several) of models and the files they reference into
+one AssetArchive, or lists and verifies an existing archive.
+****************************************************************************/
+#include "AssetArchive.h"
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+static int list(const std::string &_fname)
+{
+  auto archive = AssetArchive::open(_fname);
+  if (!archive)
+  {
+    return EXIT_FAILURE;
+  }
+  size_t bad = 0;
+  size_t total = 0;
+  for (auto &name : archive->names())
+  {
+    const AssetArchive::Entry *entry = archive->find(name);
+    bool ok = AssetArchive::hash(entry->data, entry->size) == entry->hash;
+    bad += ok ? 0 : 1;
+    total += entry->size;
+    std::cout << (ok ? "  " : "! ") << name << " " << entry->size << "\n";
+  }
+  std::cout << archive->names().size() << " files " << total << " bytes";
+  if (bad != 0)
+  {
+    std::cout << ", " << bad << " failed the hash check\n";
+    return EXIT_FAILURE;
+  }
+  std::cout << "\n";
+  return EXIT_SUCCESS;
+}
+
+int main(int argc, char **argv)
+{
+  // usage AssetPacker out.aip dir [dir...]  or  AssetPacker --list in.aip
+  if (argc == 3 && std::string(argv[1]) == "--list")
+  {
+    return list(argv[2]);
+  }
+  if (argc < 3)
+  {
+    std::cout << "usage AssetPacker out.aip dir [dir...]\n      AssetPacker --list in.aip\n";
+    return EXIT_FAILURE;
+  }
+  // names are relative to the directory they were found in so the models can find their own
+  // dependencies (md5anim, textures etc.) with the same relative paths they use on disk
+  std::vector<std::pair<std::string, std::string>> files;
+  for (int i = 2; i < argc; ++i)
+  {
+    fs::path root(argv[i]);
+    if (!fs::is_directory(root))
+    {
+      std::cerr << root << " is not a directory\n";
+      return EXIT_FAILURE;
+    }
+    for (auto &entry : fs::recursive_directory_iterator(root))
+    {
+      if (entry.is_regular_file())
+      {
+        files.emplace_back(fs::relative(entry.path(), root).generic_string(), entry.path().string());
+      }
+    }
+  }
+  // sorted so the same input always gives the same archive
+  std::sort(files.begin(), files.end());
+  auto duplicate = std::adjacent_find(files.begin(), files.end(),
+                                      [](const auto &_a, const auto &_b) { return _a.first == _b.first; });
+  if (duplicate != files.end())
+  {
+    std::cerr << duplicate->first << " is in more than one directory\n";
+    return EXIT_FAILURE;
+  }
+  if (!AssetArchive::write(argv[1], files))
+  {
+    return EXIT_FAILURE;
+  }
+  std::cout << "packed " << files.size() << " files into " << argv[1] << "\n";
+  return EXIT_SUCCESS;
+}